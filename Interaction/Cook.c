@@ -0,0 +1,194 @@
+/******************************************************************
+*
+* Cook.c
+*
+* Description: Command line tool converting OBJ files into binary
+*              mesh cache files that are mapped at startup instead
+*              of parsing the text files.
+*
+*              Usage: Cook [-b] file.obj ...
+*
+*              For every cooked file the number of positions and
+*              normals, the unified vertices built from them and
+*              the time for building them is reported, followed by
+*              what the cleanup removed, the vertex cache reuse
+*              before and after reordering and the triangles and
+*              error of every level of detail.
+*
+*              With -b, no files are written; instead the time for
+*              parsing the OBJ file, reading the cache into memory
+*              and mapping the cache is reported for every file.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+
+/* Standard includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Local includes */
+#include "OBJParser.h"     /* Loading function for triangle meshes in OBJ format */
+#include "Mesh.h"          /* Flat mesh arrays */
+#include "MeshCache.h"     /* Binary mesh cache files */
+#include "MeshClean.h"     /* Welding and removal of unused mesh parts */
+#include "MeshOptimize.h"  /* Vertex cache friendly ordering */
+#include "MeshSimplify.h"  /* Levels of detail */
+
+
+/* Number of repetitions for each benchmark measurement */
+#define BENCHMARK_RUNS 20
+
+
+/******************************************************************
+*
+* Seconds
+*
+* Monotonic wall clock time in seconds
+*
+*******************************************************************/
+
+double Seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+
+/******************************************************************
+*
+* CookFile
+*
+* Parse OBJ file, clean it up, reorder it for the vertex cache and
+* build its levels of detail, write its mesh cache and report what
+* each step did
+*
+*******************************************************************/
+
+int CookFile(char *filename)
+{
+    mesh cooked;
+    mesh_build_report report;
+    mesh_clean_report clean;
+    mesh_optimize_report optimize;
+    mesh_simplify_report simplify;
+    int success;
+    int i;
+
+    if(!mesh_load_obj(&cooked, filename, &report))
+        return 0;
+
+    printf("%-32s %6d positions %6d normals %6d texcoords -> %6d vertices %6d triangles %2d bit %7.3f ms\n",
+           filename, report.position_count, report.normal_count, report.texture_count,
+           report.vertex_count, report.triangle_count, cooked.index_size*8, report.build_seconds*1e3);
+
+    if(!mesh_clean(&cooked, MESH_CLEAN_EPSILON, &clean) || !mesh_optimize(&cooked, &optimize) ||
+       !mesh_simplify_lods(&cooked, &simplify)){
+        mesh_free(&cooked);
+        return 0;
+    }
+
+    printf("%-32s %6d welded %6d unused %6d degenerate %6d duplicate   %zu -> %zu bytes %7.3f ms\n", "",
+           clean.welded, clean.unused, clean.degenerate, clean.duplicate,
+           clean.bytes_before, clean.bytes_after, clean.seconds*1e3);
+    printf("%-32s ACMR %.3f -> %.3f   ATVR %.3f -> %.3f   %7.3f ms\n", "", optimize.acmr_before,
+           optimize.acmr_after, optimize.atvr_before, optimize.atvr_after, optimize.seconds*1e3);
+    printf("%-32s LOD", "");
+    for(i=0; i<simplify.lod_count; i++)
+        printf(" %d (%.4f)", simplify.triangle_count[i], simplify.error[i]);
+    printf("   %7.3f ms\n", simplify.seconds*1e3);
+
+    success = mesh_cache_write(filename, &cooked);
+
+    mesh_free(&cooked);
+    return success;
+}
+
+
+/******************************************************************
+*
+* BenchmarkFile
+*
+* Compare cold text parse, reading the cache into memory and
+* mapping the cache; each measurement is averaged over several runs
+*
+*******************************************************************/
+
+void BenchmarkFile(char *filename)
+{
+    mesh loaded;
+    double start, parse_time, read_time, map_time;
+    int i;
+
+    start = Seconds();
+    for(i=0; i<BENCHMARK_RUNS; i++){
+        if(!mesh_load_obj(&loaded, filename, NULL)){
+            fprintf(stderr, "Could not parse %s\n", filename);
+            return;
+        }
+        mesh_free(&loaded);
+    }
+    parse_time = (Seconds() - start)/BENCHMARK_RUNS;
+
+    start = Seconds();
+    for(i=0; i<BENCHMARK_RUNS; i++){
+        if(!mesh_cache_read(filename, &loaded)){
+            fprintf(stderr, "No fresh cache for %s, run cook first\n", filename);
+            return;
+        }
+        mesh_free(&loaded);
+    }
+    read_time = (Seconds() - start)/BENCHMARK_RUNS;
+
+    start = Seconds();
+    for(i=0; i<BENCHMARK_RUNS; i++){
+        mesh_cache_map(filename, &loaded);
+        mesh_free(&loaded);
+    }
+    map_time = (Seconds() - start)/BENCHMARK_RUNS;
+
+    printf("%-32s parse %8.3f ms   cache read %7.3f ms   cache map %7.3f ms\n",
+           filename, parse_time*1e3, read_time*1e3, map_time*1e3);
+}
+
+
+/******************************************************************
+*
+* main
+*
+*******************************************************************/
+
+int main(int argc, char** argv)
+{
+    int benchmark = 0;
+    int failed = 0;
+    int i;
+
+    if(argc > 1 && strcmp(argv[1], "-b") == 0)
+        benchmark = 1;
+
+    if(argc < 2 + benchmark){
+        fprintf(stderr, "Usage: %s [-b] file.obj ...\n", argv[0]);
+        return 1;
+    }
+
+    for(i=1+benchmark; i<argc; i++){
+        if(benchmark){
+            BenchmarkFile(argv[i]);
+        }
+        else if(!CookFile(argv[i])){
+            fprintf(stderr, "Could not cook %s\n", argv[i]);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
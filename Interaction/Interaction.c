@@ -36,6 +36,15 @@
 #include "LoadShader.h"    /* Loading function for shader code */
 #include "Matrix.h"        /* Functions for matrix handling */
 #include "OBJParser.h"     /* Loading function for triangle meshes in OBJ format */
+#include "ThreadPool.h"    /* Worker threads for loading models concurrently */
+#include "Mesh.h"          /* Flat mesh arrays for buffer upload */
+#include "MeshCache.h"     /* Binary cache of cooked meshes */
+#include "MeshClean.h"     /* Welding and removal of unused mesh parts */
+#include "MeshOptimize.h"  /* Vertex cache friendly ordering of meshes */
+#include "MeshSimplify.h"  /* Levels of detail of meshes */
+#include "SceneGraph.h"    /* Transform hierarchy of the mobile */
+#include "Render.h"        /* Vertex arrays and filtered GL state changes */
+#include "Cull.h"          /* View frustum culling of the models */
 
 
 /*----------------------------------------------------------------*/
@@ -44,14 +53,27 @@
 GLboolean anim = GL_TRUE;
 GLboolean anim_cam = GL_FALSE;						// Anim var for automatic camera mode
 
-/* Define handles to two vertex buffer objects */
-GLuint VBO[15];
+/* Shared vertex and index buffer of all models; part of it used by
+ * every model */
+render_arena RenderArena;
+render_mesh RenderMesh[15];
 
-/* Define handles to two index buffer objects */
-GLuint IBO[15];
+/* Levels of detail of every model, the finest being RenderMesh; the
+ * level drawn is picked per frame from the size of its error on
+ * screen, at the center of the bounding sphere of the mesh */
+render_mesh RenderLod[15][MESH_MAX_LODS];
+int LodCount[15];
+int LodLevel[15];
 
-/* Indices to vertex attributes; in this case positon only */ 
-enum DataID {vPosition = 0}; 
+/* Largest error of a drawn level in pixels; a coarser level is only
+ * taken once its error is below this fraction of it, so levels do
+ * not flicker at the threshold */
+#define LOD_PIXEL_ERROR 1.0f
+#define LOD_HYSTERESIS 0.75f
+
+/* Shadowed GL state and call counters; draw commands of one frame */
+render_state RenderState;
+render_commands DrawCommands;
 
 /* Strings for loading and storing shader code */
 static const char* VertexShaderString;
@@ -65,33 +87,25 @@ float ProjectionMatrix[16]; /* Perspective projection matrix */
 float ViewMatrix[16];       /* Camera view matrix */ 
 float ModelMatrix[15][16];      /* Model matrix for each .obj file */
 
+/* Products uploaded to the shader, recomputed only when their factors
+ * changed: ViewDirty for projection or view, ModelDirty per model */
+float ViewProjectionMatrix[16];
+float MVPMatrix[15][16];
+GLboolean ViewDirty = GL_TRUE;
+GLboolean ModelDirty[15] = {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE,
+                            GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE};
+
+/* World bounds of the models, updated with their MVP matrices, and
+ * the planes of the view frustum, updated with the view */
+cull_batch ModelBounds;
+cull_frustum ViewFrustum;
 
-/* Transformation matrices for model rotation */			// NEW: For every object Rotation Matrices
-float RotationMatrixAnimX[16];
-float RotationMatrixAnimY[16];
-float RotationMatrixAnimZ[16];
-float RotationMatrixAnim[16];
 
-float RotationMatrixAnimY2[16];		                               // NEW: additional rotation matrices
-float RotationMatrixAnimY3[16];								
-    
 /* Variables for storing current rotation angles */			// NEW: fore some objects different Rotation angles
 float angleY= 0.0f; 
 float angleY2 = 0.0f;										
   
 
-/* Identity Matrix: filler for Multiplication-gaps  */
-float IdentityMatrixAnim[16];
-
-/* Extra Translation Matrix to Translate from/to center */              // NEW: Translation matrices for ball models
-float TranslationMatrixAnim[16];
-float TranslationMatrixAnim2[16];
-float TranslationMatrixAnim3[16];
-float TranslationMatrixAnim4[16];
-float TranslationMatrixAnim5[16];
-float TranslationMatrixAnim6[16];
-
-
 
 /* Indices to active rotation axes */
 enum {YaxisStop=0, Yaxis=1};
@@ -104,17 +118,45 @@ enum {Model1=0, Model2=1, Model3=3, Model4=4, Model5=5, Model6=6, Model7=7,
 int model = Model1; 
 int model_count = 15;                                                 
 
-  
-/* Arrays for holding vertex data of the two models */				
-GLfloat *vertex_buffer_data[15];
+/* Models moved on their own in the mobile */
+enum {TopBar=1, Ball1=6, Ball2=7, EllipticRing=11};
 
+/* Node of the mobile holding every part that turns with angleY */
+#define MOBILE -2
 
-/* Arrays for holding indices of the two models */
-GLushort *index_buffer_data[15];
+/* Parent of every model in the mobile: the top ring and background
+ * stay fixed, the top bar turns the other way and carries the balls,
+ * all other parts hang from the mobile node */
+const int ModelParent[15] = {SCENE_GRAPH_NONE, SCENE_GRAPH_NONE, MOBILE, MOBILE, MOBILE, MOBILE, TopBar, TopBar,
+                             MOBILE, MOBILE, MOBILE, MOBILE, MOBILE,
+                             SCENE_GRAPH_NONE, SCENE_GRAPH_NONE};
 
+/* Transform hierarchy of the models; only nodes below changed joints
+ * get new model matrices */
+scene_graph Scene;
+int ModelNode[15];
+int MobileNode;
 
-/* Structures for loading of OBJ data */
-obj_scene_data data[15];
+  
+/* Vertex and index arrays of the models; either converted from the
+ * OBJ data or mapped directly from the mesh cache */
+mesh mesh_data[15];
+
+/* Model whose mesh model k draws; models with identical meshes share
+ * the first one, and only that one keeps its arrays and is uploaded */
+int MeshSource[15];
+
+/* Parameters and result of loading one model on a worker thread */
+typedef struct
+{
+    int index;
+    char *filename;
+    int success;
+    int cached;
+    mesh_clean_report clean;        /* Only for meshes not taken from the cache */
+    mesh_optimize_report optimize;
+    mesh_simplify_report simplify;
+} ModelLoadJob;
 
 /* Reference time for animation */
 int oldTime = 0;
@@ -135,18 +177,102 @@ float aspect = 1.0;                                 // aspect == ratio of width
 float nearPlane = 1.0; 
 float farPlane = 100.0;
 
-float RotationMatrixCam[16];		
-float RotationMatrixCam2[16];	
-float RotationMatrixCam3[16];
 int camMov1 = 0;
 int camMov2 = 0;
 
-
-float TranslationMatrixCam[16];
 /*----------------------------------------------------------------*/
 
 
 
+/******************************************************************
+*
+* UpdateMVPMatrices
+*
+* Recompute projection * view * model of every model whose factors
+* changed since the last frame, along with the frustum planes and the
+* world bounds of the models
+*
+*******************************************************************/
+
+void UpdateMVPMatrices()
+{
+  int i;
+
+  if(ViewDirty){
+    MultiplyMatrix(ProjectionMatrix, ViewMatrix, ViewProjectionMatrix);
+    cull_frustum_make(ViewProjectionMatrix, &ViewFrustum);
+    for(i=0; i<model_count; ++i)
+      ModelDirty[i] = GL_TRUE;
+    ViewDirty = GL_FALSE;
+  }
+
+  for(i=0; i<model_count; ++i){
+    if(ModelDirty[i]){
+      MultiplyMatrix(ViewProjectionMatrix, ModelMatrix[i], MVPMatrix[i]);
+      cull_batch_set(&ModelBounds, i, &mesh_data[MeshSource[i]].bounds, ModelMatrix[i]);
+      ModelDirty[i] = GL_FALSE;
+    }
+  }
+}
+
+
+/******************************************************************
+*
+* SelectLevels
+*
+* Pick the level of detail of every model: the coarsest one whose
+* error, projected at the depth of the model center, stays below
+* LOD_PIXEL_ERROR pixels
+*
+*******************************************************************/
+
+void SelectLevels()
+{
+  float pixels_per_unit, scale, column, w, pixels;
+  const float *center, *mvp, *model_matrix;
+  const mesh *source;
+  int i, j, level;
+
+  /* Pixels per model unit at depth 1 along the view direction */
+  pixels_per_unit = ProjectionMatrix[5] * glutGet(GLUT_WINDOW_HEIGHT) * 0.5f;
+
+  for(i=0; i<model_count; ++i){
+    source = &mesh_data[MeshSource[i]];
+    center = source->bounds.center;
+    mvp = MVPMatrix[i];
+    model_matrix = ModelMatrix[i];
+    level = LodLevel[i];
+
+    /* Errors are in model units; the longest axis of the model matrix
+     * bounds how much they grow */
+    scale = 0.0f;
+    for(j=0; j<3; ++j){
+      column = model_matrix[j]*model_matrix[j] + model_matrix[4+j]*model_matrix[4+j] +
+               model_matrix[8+j]*model_matrix[8+j];
+      if(column > scale)
+        scale = column;
+    }
+    scale = sqrtf(scale);
+
+    /* Clip space w is the distance along the view direction */
+    w = mvp[12]*center[0] + mvp[13]*center[1] + mvp[14]*center[2] + mvp[15];
+    if(w <= nearPlane || LodCount[i] <= 1){
+      LodLevel[i] = 0;
+      continue;
+    }
+    pixels = scale * pixels_per_unit / w;
+
+    while(level > 0 && source->lods[level].error * pixels > LOD_PIXEL_ERROR)
+      level--;
+    while(level + 1 < LodCount[i] &&
+          source->lods[level + 1].error * pixels <= LOD_PIXEL_ERROR * LOD_HYSTERESIS)
+      level++;
+
+    LodLevel[i] = level;
+  }
+}
+
+
 /******************************************************************
 *
 * Display
@@ -160,70 +286,58 @@ float TranslationMatrixCam[16];
 
 void Display()								// NEW: 2 models center in point of origin
 {
-  /* Clear window; color specified in 'Initialize()' */
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    
   int i;
-  for(i=0; i<model_count; ++i){
-    glEnableVertexAttribArray(vPosition);
 
-    /* Bind buffer with vertex data of currently active object */
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[i]);
-    glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
-     
+  UpdateMVPMatrices();
+  cull_batch_test(&ModelBounds, &ViewFrustum);
+  SelectLevels();
 
-    /* Bind buffer with index data of currently active object */
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO[i]);
-    
-    
-    GLint size; 
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+  render_frame_begin(&RenderState);
 
-    /* Associate program with uniform shader matrices */
-    GLint projectionUniform = glGetUniformLocation(ShaderProgram, "ProjectionMatrix");
-    if (projectionUniform == -1) 
-    {
-        fprintf(stderr, "Could not bind uniform ProjectionMatrix\n");
-	exit(-1);
-    }
-    glUniformMatrix4fv(projectionUniform, 1, GL_TRUE, ProjectionMatrix);
-    
-    GLint ViewUniform = glGetUniformLocation(ShaderProgram, "ViewMatrix");
-    if (ViewUniform == -1) 
-    {
-        fprintf(stderr, "Could not bind uniform ViewMatrix\n");
-        exit(-1);
-    }
-    glUniformMatrix4fv(ViewUniform, 1, GL_TRUE, ViewMatrix);
-   
-    GLint RotationUniform = glGetUniformLocation(ShaderProgram, "ModelMatrix");
-    if (RotationUniform == -1) 
-    {
-        fprintf(stderr, "Could not bind uniform ModelMatrix\n");
-        exit(-1);
-    }
-    
-    glUniformMatrix4fv(RotationUniform, 1, GL_TRUE, ModelMatrix[i]);  	
+  /* Clear window; color specified in 'Initialize()' */
+  render_clear(&RenderState, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // How to make initial transformation of loaded objects?                            ???
-    
-    /* Set state to only draw wireframe (no lighting used, yet) */
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); 
+  /* Set state to only draw wireframe (no lighting used, yet) */
+  render_polygon_mode(&RenderState, GL_LINE);
 
-    /* Issue draw command, using indexed triangle list */
-    glDrawElements(GL_TRIANGLES, size/sizeof(GLushort), GL_UNSIGNED_SHORT, 0);
-    
+  /* All models inside the view frustum with their own matrix in one
+   * submission */
+  DrawCommands.count = 0;
+  for(i=0; i<model_count; ++i){
+    if(!ModelBounds.visible[i])
+      continue;
+    render_command *command = render_commands_push(&DrawCommands);
+    if(command == NULL)
+      break;
+    command->mesh = &RenderLod[i][LodLevel[i]];
+    command->matrix = MVPMatrix[i];
+  }
+  render_arena_execute(&RenderState, &RenderArena, DrawCommands.items, DrawCommands.count);
 
-    /* Disable attributes */
-    glDisableVertexAttribArray(vPosition);
-    
-  }  
+  render_frame_end(&RenderState);
 
   /* Swap between front and back buffer */ 
   glutSwapBuffers();
 }
 
 
+/******************************************************************
+*
+* Shutdown
+*
+* Release the shared buffers and the draw list before the program
+* ends; the shadowed GL state is forgotten with them
+*
+*******************************************************************/
+
+void Shutdown()
+{
+    render_arena_free(&RenderState, &RenderArena);
+    render_commands_free(&DrawCommands);
+    render_state_reset(&RenderState);
+}
+
+
 /******************************************************************
 *
 * Mouse
@@ -251,6 +365,7 @@ void Mouse(int button, int state, int x, int y)
 	        break;
 		
 	    case GLUT_RIGHT_BUTTON: 					
+		Shutdown();
 		exit(0);    
 		break;
 	}
@@ -301,6 +416,13 @@ void Keyboard(unsigned char key, int x, int y){
     case 'c' :
 	yy += 0.1f;
         break;
+    case 'g' :      // print GL calls of the last frame
+        printf("GL calls per frame: %u (%u redundant filtered), %u draws, %u triangles\n", 
+               RenderState.frame_calls, RenderState.frame_filtered, RenderState.frame_draws,
+               RenderState.frame_triangles);
+        printf("Models drawn: %d, culled: %d (%.4f ms)\n", 
+               ModelBounds.visible_count, ModelBounds.culled_count, ModelBounds.seconds*1e3);
+        return;
     case 'm' :	// set automatic camera mode and reset camera position an rotation (angle)
 	anim_cam = GL_TRUE;
         camera_disp = -10.0;
@@ -311,6 +433,7 @@ void Keyboard(unsigned char key, int x, int y){
         xx=0;
         yy=0;
         SetTranslation(xx, yy, camera_disp, ViewMatrix);  // camera_disp == z coordinate of camera
+        ViewDirty = GL_TRUE;
 	return;
 	break;
     case 'n' :	// unset automatic camera mode and reset camera position an rotation (angle)
@@ -323,26 +446,79 @@ void Keyboard(unsigned char key, int x, int y){
         xx=0;
         yy=0;
         SetTranslation(xx, yy, camera_disp, ViewMatrix);  // camera_disp == z coordinate of camera
+        ViewDirty = GL_TRUE;
 	return;
 	break;
   }
-  SetIdentityMatrix(RotationMatrixCam);
-  SetIdentityMatrix(RotationMatrixCam2);
-  SetIdentityMatrix(RotationMatrixCam3);
-  SetIdentityMatrix(TranslationMatrixCam);
-  
-  // set camera movement
-  SetTranslation(xx, yy, camera_disp, TranslationMatrixCam);
-  SetRotationX(angle2, RotationMatrixCam);                            
-  SetRotationY(angle3, RotationMatrixCam2);                        
-  
-  // apply movement to viewMatrix (camera matrix)
-  MultiplyMatrix(RotationMatrixCam, RotationMatrixCam2, RotationMatrixCam3);
-  MultiplyMatrix(RotationMatrixCam3, TranslationMatrixCam, ViewMatrix);
+  // apply camera movement to viewMatrix (camera matrix)
+  SetRotationX(angle2, ViewMatrix);
+  RotateMatrixY(ViewMatrix, angle3);
+  TranslateMatrix(ViewMatrix, xx, yy, camera_disp);
+  ViewDirty = GL_TRUE;
   glutPostRedisplay();
 }
 
 
+/******************************************************************
+*
+* BuildScene
+*
+* Add every model to the transform hierarchy of the mobile below its
+* parent; the balls and the elliptic ring are moved to the center
+* they spin about
+*
+*******************************************************************/
+
+void BuildScene()
+{
+    float ball1[3] = {-1.8, 1, -1.8};                                   // ball_01          -1,8/1,8/1
+    float ball2[3] = {1.8, 1, 1.8};                                     // ball_02           1,8/-1,8/1
+    float ring[3] = {-0.96, -1.73403, -0.66};                           // elliptic_ring    -0,96/0,66/-1,73403
+    int k, parent;
+
+    scene_graph_make(&Scene);
+    MobileNode = scene_graph_add(&Scene, SCENE_GRAPH_NONE);
+
+    /* Parents come before their children in the model order */
+    for(k=0; k<model_count; ++k){
+      parent = ModelParent[k];
+      if(parent == MOBILE)
+        parent = MobileNode;
+      else if(parent != SCENE_GRAPH_NONE)
+        parent = ModelNode[parent];
+      ModelNode[k] = scene_graph_add(&Scene, parent);
+    }
+
+    scene_graph_set_translation(&Scene, ModelNode[Ball1], ball1[0], ball1[1], ball1[2]);
+    scene_graph_set_translation(&Scene, ModelNode[Ball2], ball2[0], ball2[1], ball2[2]);
+    scene_graph_set_translation(&Scene, ModelNode[EllipticRing], ring[0], ring[1], ring[2]);
+}
+
+
+/******************************************************************
+*
+* UpdateModelMatrices
+*
+* Recompute the world matrices of the moved parts of the hierarchy
+* and take over those of the models among them
+*
+*******************************************************************/
+
+void UpdateModelMatrices()
+{
+    int k;
+
+    scene_graph_update(&Scene);
+
+    for(k=0; k<model_count; ++k){
+      if(scene_graph_changed(&Scene, ModelNode[k])){
+        memcpy(ModelMatrix[k], scene_graph_world(&Scene, ModelNode[k]), sizeof(ModelMatrix[k]));
+        ModelDirty[k] = GL_TRUE;
+      }
+    }
+}
+
+
 /******************************************************************
 *
 * OnIdle
@@ -357,8 +533,6 @@ void OnIdle(){
     int newTime = glutGet(GLUT_ELAPSED_TIME);
     int delta = newTime - oldTime;
     oldTime = newTime;
-    SetIdentityMatrix(IdentityMatrixAnim);
-    SetIdentityMatrix(TranslationMatrixAnim);
 
     /* automatic camera mode: press 'm' to start, and 'n' to reset */			
     if(anim_cam){
@@ -404,30 +578,18 @@ void OnIdle(){
         }
         ++camMov1;
             
-        SetIdentityMatrix(RotationMatrixCam);
-        SetIdentityMatrix(RotationMatrixCam2);
-        
-	SetTranslation(0.0, 0.0, camera_disp, TranslationMatrixAnim);      // translate cameras z position
-              
-	SetRotationY(angle, RotationMatrixCam);                            // set rotation of camera
-	SetRotationX(angle1, RotationMatrixCam2);
-        MultiplyMatrix(RotationMatrixCam, TranslationMatrixAnim, RotationMatrixCam3);   
-        MultiplyMatrix(RotationMatrixCam3, RotationMatrixCam2, ViewMatrix);
+        SetRotationY(angle, ViewMatrix);                                   // set rotation of camera
+        TranslateMatrix(ViewMatrix, 0.0, 0.0, camera_disp);                // translate cameras z position
+        RotateMatrixX(ViewMatrix, angle1);
+        ViewDirty = GL_TRUE;
     }
 
     
     /* If animation is set to true, set new rotation angles */
     if(anim){
-        /* Increment rotation angles and update matrix */
-        if(axis == YaxisStop){
-	     // angleY = 0;
-	      SetRotationY(angleY, RotationMatrixAnimY);  
-	      
-	      
-	}
-	else if(axis == Yaxis){
+        /* Increment rotation angles */
+	if(axis == Yaxis){
 	    angleY = fmod(angleY + delta/20.0, 360.0); 
-	    SetRotationY(angleY, RotationMatrixAnimY);  
 	}  
     }
     else {	/* else: do not apply rotation below */
@@ -435,69 +597,145 @@ void OnIdle(){
     }
 
     
-    // Set Translation for Center-Imported Objects (ball_01, ball_02 and ring)                  // NEW
-    SetIdentityMatrix(IdentityMatrixAnim);
-    SetIdentityMatrix(TranslationMatrixAnim);
-    SetIdentityMatrix(TranslationMatrixAnim2);
-    SetIdentityMatrix(TranslationMatrixAnim3);
-    SetIdentityMatrix(TranslationMatrixAnim4);
-    SetIdentityMatrix(TranslationMatrixAnim5);
+    /* Joints of the mobile: everything below the mobile node rotates
+     * about the Y axis, the top bar in the other direction at double
+     * speed; the balls and the ring also spin about their own center,
+     * the angles relative to their parent */
+    angleY2 = -fmod(angleY + delta/20.0, 360.0);
+    scene_graph_set_rotation(&Scene, MobileNode, 0.0, angleY, 0.0);
+    scene_graph_set_rotation(&Scene, ModelNode[TopBar], 0.0, 2*angleY2, 0.0);
+    scene_graph_set_rotation(&Scene, ModelNode[Ball1], 0.0, angleY2, 0.0);      // 3*angleY2 with the top bar
+    scene_graph_set_rotation(&Scene, ModelNode[Ball2], 0.0, angleY2, 0.0);
+    scene_graph_set_rotation(&Scene, ModelNode[EllipticRing], 0.0, 2*angleY, 0.0);  // 3*angleY with the mobile
+
+    UpdateModelMatrices();
     
-    SetTranslation(-1.8, 1, -1.8, TranslationMatrixAnim);               // ball_01          -1,8/1,8/1
-    SetTranslation(1.8, 1, 1.8, TranslationMatrixAnim3);                // ball_02           1,8/-1,8/1
-    SetTranslation(-0.96, -1.73403, -0.66, TranslationMatrixAnim5);     // elliptic_ring    -0,96/0,66/-1,73403
-    
-    /* Rotation of models */
-    int k;		
-    for(k=1; k<13; ++k){         // do not rotate top ring (index 0) and fixed background structures (index 13 and 14)
-       
-      // Set main rotaiton
-      /* Update of transformation matrices 
-       * Note order of transformations and rotation of reference axes */
-      SetIdentityMatrix(IdentityMatrixAnim);
-      MultiplyMatrix(IdentityMatrixAnim, RotationMatrixAnimY, RotationMatrixAnim);
-      
-      
-      // rotate top bar in different direction and double the rotation speed
-      if(k==1 || k==6 || k == 7){	
-	angleY2 = -fmod(angleY + delta/20.0, 360.0);	
-	SetRotationY(angleY2, RotationMatrixAnimY2);
-        
-        // in daddition: rotate models ball_01 and ball_02 around their own center
-        if(k==6){
-            MultiplyMatrix(RotationMatrixAnimY2, RotationMatrixAnimY2, RotationMatrixAnimY3);
-            MultiplyMatrix(RotationMatrixAnimY3, TranslationMatrixAnim, TranslationMatrixAnim2);
-            MultiplyMatrix(TranslationMatrixAnim2, RotationMatrixAnimY2, ModelMatrix[k]);
-            continue;
-        }
-        else if(k==7){
-            MultiplyMatrix(RotationMatrixAnimY2, RotationMatrixAnimY2, RotationMatrixAnimY3);
-            MultiplyMatrix(RotationMatrixAnimY3, TranslationMatrixAnim3, TranslationMatrixAnim2);
-            MultiplyMatrix(TranslationMatrixAnim2, RotationMatrixAnimY2, ModelMatrix[k]);
-            continue;
-        } 
-
-	MultiplyMatrix(RotationMatrixAnimY2, IdentityMatrixAnim, ModelMatrix[k]);	
-	MultiplyMatrix(RotationMatrixAnimY2,RotationMatrixAnimY2,ModelMatrix[k]);
-	
-      }
-     
-      
-      else {
-        // additional rotation of ring with double speed oround its center
-        if(k==11){
-            MultiplyMatrix(RotationMatrixAnimY, TranslationMatrixAnim5, RotationMatrixAnimY3);
-            MultiplyMatrix(RotationMatrixAnimY3, RotationMatrixAnimY, TranslationMatrixAnim4);
-            MultiplyMatrix(TranslationMatrixAnim4, RotationMatrixAnimY, ModelMatrix[k]);
-            continue;
+    /* Issue display refresh */
+    glutPostRedisplay();
+}
+
+
+/******************************************************************
+*
+* LoadModel
+*
+* Worker thread job: map the cooked mesh of one model, or parse
+* its OBJ file into interleaved vertex and index arrays and build
+* its levels of detail
+*
+*******************************************************************/
+
+void LoadModel(void *argument)
+{
+    ModelLoadJob *job = (ModelLoadJob*) argument;
+    int k = job->index;
+
+    /* A fresh cooked mesh is mapped and used without any parsing */
+    job->cached = mesh_cache_map(job->filename, &mesh_data[k]);
+    if(job->cached){
+      job->success = 1;
+      return;
+    }
+
+    /* Parse into flat arrays and build unified vertices */
+    job->success = mesh_load_obj(&mesh_data[k], job->filename, NULL);
+
+    /* Clean up and reorder for the vertex cache once; the cache keeps
+     * the result */
+    if(job->success)
+      job->success = mesh_clean(&mesh_data[k], MESH_CLEAN_EPSILON, &job->clean);
+    if(job->success)
+      job->success = mesh_optimize(&mesh_data[k], &job->optimize);
+
+    /* A model that could not be loaded is left empty and not drawn */
+    if(!job->success){
+      mesh_free(&mesh_data[k]);
+      return;
+    }
+
+    /* Without the coarser levels the full mesh is still drawn and
+     * cooked, as the only level */
+    if(!mesh_simplify_lods(&mesh_data[k], &job->simplify)){
+      mesh_data[k].lods[0].first_index = 0;
+      mesh_data[k].lods[0].index_count = mesh_data[k].index_count;
+      mesh_data[k].lods[0].error = 0.0f;
+      mesh_data[k].lod_count = 1;
+
+      job->simplify.lod_count = 1;
+      job->simplify.triangle_count[0] = mesh_data[k].index_count / 3;
+      job->simplify.error[0] = 0.0f;
+      job->simplify.seconds = 0.0;
+    }
+
+    /* Cook the mesh for the next start */
+    mesh_cache_write(job->filename, &mesh_data[k]);
+}
+
+
+/******************************************************************
+*
+* ShareDuplicateMeshes
+*
+* Point every model whose mesh equals the mesh of an earlier model
+* at that model and free its own copy; returns number of unique meshes
+*
+*******************************************************************/
+
+int ShareDuplicateMeshes()
+{
+    uint64_t hash[15];
+    int unique = 0;
+    int j, k;
+
+    for(k=0; k<model_count; ++k){
+      hash[k] = mesh_hash(&mesh_data[k]);
+      MeshSource[k] = k;
+
+      /* Equal hashes are confirmed by comparing the contents */
+      for(j=0; j<k; ++j){
+        if(MeshSource[j] == j && hash[j] == hash[k] && mesh_equal(&mesh_data[j], &mesh_data[k])){
+          MeshSource[k] = j;
+          mesh_free(&mesh_data[k]);
+          break;
         }
-        MultiplyMatrix(RotationMatrixAnim, IdentityMatrixAnim, ModelMatrix[k]);			
       }
-      
+      unique += MeshSource[k] == k;
     }
-    
-    /* Issue display refresh */
-    glutPostRedisplay();
+
+    return unique;
+}
+
+
+/******************************************************************
+*
+* ReportModel
+*
+* Print what loading a model did; returns 1 if it came from the mesh
+* cache
+*
+*******************************************************************/
+
+int ReportModel(ModelLoadJob *job)
+{
+    int k;
+
+    if(!job->success)
+      printf("Could not load %s, the model is not drawn.\n", job->filename);
+    else if(!job->cached){
+      printf("%-28s %d welded, %d unused vertices, %d degenerate, %d duplicate triangles: "
+             "%zu -> %zu bytes (%.3f ms)\n", job->filename, job->clean.welded, job->clean.unused,
+             job->clean.degenerate, job->clean.duplicate, job->clean.bytes_before,
+             job->clean.bytes_after, job->clean.seconds*1e3);
+      printf("%-28s ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  (%.3f ms)\n", job->filename,
+             job->optimize.acmr_before, job->optimize.acmr_after,
+             job->optimize.atvr_before, job->optimize.atvr_after, job->optimize.seconds*1e3);
+      printf("%-28s levels of detail:", job->filename);
+      for(k=0; k<job->simplify.lod_count; ++k)
+        printf(" %d", job->simplify.triangle_count[k]);
+      printf(" triangles (%.3f ms)\n", job->simplify.seconds*1e3);
+    }
+
+    return job->cached;
 }
 
 
@@ -505,27 +743,77 @@ void OnIdle(){
 *
 * SetupDataBuffers
 *
-* Create buffer objects and load data into buffers
+* Wait for all models, then copy every unique mesh once into one
+* shared vertex and index buffer; returns number of models taken from
+* the mesh cache
 *
 *******************************************************************/
 
-void SetupDataBuffers()
+int SetupDataBuffers(thread_pool *pool)
 {
-  
-    int i;
-    for(i=0; i<model_count; ++i){
-      glGenBuffers(1, &VBO[i]);
-      glBindBuffer(GL_ARRAY_BUFFER, VBO[i]);
-      glBufferData(GL_ARRAY_BUFFER, data[i].vertex_count*3*sizeof(GLfloat), vertex_buffer_data[i], GL_STATIC_DRAW);   
+    ModelLoadJob *job;
+    int k;
+    int cached = 0;
+    int unique;
+    int format = 0;
+    int vertex_count = 0;
+    int index_count = 0;
+    int index_size = 1;
+
+    while(thread_pool_wait_next(pool, (void**)&job))
+      cached += ReportModel(job);
+
+    unique = ShareDuplicateMeshes();
+    printf("%d of %d models have a unique mesh\n", unique, model_count);
+
+    /* Normals are the only optional attribute the shader reads */
+    for(k=0; k<model_count; ++k){
+      if(MeshSource[k] != k)
+        continue;
+      format |= mesh_data[k].format & MESH_NORMAL;
+      vertex_count += mesh_data[k].vertex_count;
+      index_count += mesh_data[k].index_count;
+      if(mesh_data[k].index_size > index_size)
+        index_size = mesh_data[k].index_size;
     }
-    
-  
-    for(i=0; i<model_count; ++i){
-      glGenBuffers(1, &IBO[i]);
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO[i]);
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, data[i].face_count*3*sizeof(GLushort), index_buffer_data[i], GL_STATIC_DRAW);
+
+    if(!render_arena_make(&RenderState, &RenderArena, format, vertex_count, index_count, index_size)){
+      fprintf(stderr, "Could not create buffer objects\n");
+      exit(1);
     }
-    
+
+    /* Models sharing a mesh are drawn as instances of one draw, also
+     * while they show the same level */
+    for(k=0; k<model_count; ++k){
+      if(MeshSource[k] != k){
+        RenderMesh[k] = RenderMesh[MeshSource[k]];
+        memcpy(RenderLod[k], RenderLod[MeshSource[k]], sizeof(RenderLod[k]));
+        LodCount[k] = LodCount[MeshSource[k]];
+        continue;
+      }
+
+      /* Models that failed to load have an empty mesh and no draw */
+      LodCount[k] = 1;
+      if(mesh_data[k].index_count == 0){
+        RenderMesh[k].arena_index = -1;
+        RenderLod[k][0] = RenderMesh[k];
+        continue;
+      }
+
+      if(!render_arena_add(&RenderState, &RenderArena, &RenderMesh[k], &mesh_data[k])){
+        printf("Could not upload model %d, it is not drawn.\n", k);
+        RenderMesh[k].arena_index = -1;
+        RenderLod[k][0] = RenderMesh[k];
+        continue;
+      }
+
+      RenderLod[k][0] = RenderMesh[k];
+      for(LodCount[k]=1; LodCount[k]<mesh_data[k].lod_count; ++LodCount[k])
+        if(!render_mesh_level(&RenderArena, &RenderMesh[k], &mesh_data[k], LodCount[k], &RenderLod[k][LodCount[k]]))
+          break;
+    }
+
+    return cached;
 }
 
 
@@ -627,7 +915,7 @@ void CreateShaderProgram()
     }
 
     /* Put linked shader program into drawing pipeline */
-    glUseProgram(ShaderProgram);
+    render_use_program(&RenderState, ShaderProgram);
 }
 
 
@@ -644,9 +932,11 @@ void CreateShaderProgram()
 
 void Initialize()
 {   
-    int k, i;
-    int success;
-    int vert, indx;
+    int k;
+    int cached = 0;
+    int startTime = glutGet(GLUT_ELAPSED_TIME);
+    thread_pool pool;
+    ModelLoadJob jobs[15];
 
     /* Load OBJ models */
     char* filename[15];
@@ -667,36 +957,26 @@ void Initialize()
     filename[13] = "models_n/stand.obj";
     filename[14] = "models_n/surrounding.obj";
     
-    for(k=0; k<model_count; ++k){
-      
-      success = parse_obj_scene(&data[k], filename[k]);
-
-      if(!success)
-	  printf("Could not load file. Exiting.\n");
+    render_state_make(&RenderState);
+    render_commands_make(&DrawCommands, model_count);
+
+    /* Parse and convert all models concurrently; the parser keeps
+     * no global state, so each job only touches its own model */
+    if(!thread_pool_make(&pool, 0)){
+      fprintf(stderr, "Could not create loader threads\n");
+      exit(1);
     }
-  
-    /*  Copy mesh data from structs into appropriate arrays */ 
-    
-    for(k=0; k<model_count; ++k){
-      vert = data[k].vertex_count;
-      indx = data[k].face_count;
-
-      vertex_buffer_data[k] = (GLfloat*) calloc (vert*3, sizeof(GLfloat));
-      index_buffer_data[k] = (GLushort*) calloc (indx*3, sizeof(GLushort));
-  
-    /* Vertices */
-      for(i=0; i<vert; i++)
-      {
-	vertex_buffer_data[k][i*3] = (GLfloat)(*data[k].vertex_list[i]).e[0] ; 			
-	vertex_buffer_data[k][i*3+1] = (GLfloat)(*data[k].vertex_list[i]).e[1];
-	vertex_buffer_data[k][i*3+2] = (GLfloat)(*data[k].vertex_list[i]).e[2];
-	}
 
-    /* Indices */
-      for(i=0; i<indx; i++){
-	index_buffer_data[k][i*3] = (GLushort)(*data[k].face_list[i]).vertex_index[0];
-	index_buffer_data[k][i*3+1] = (GLushort)(*data[k].face_list[i]).vertex_index[1];
-	index_buffer_data[k][i*3+2] = (GLushort)(*data[k].face_list[i]).vertex_index[2];
+    for(k=0; k<model_count; ++k){
+      jobs[k].index = k;
+      jobs[k].filename = filename[k];
+      jobs[k].success = 0;
+      jobs[k].cached = 0;
+
+      /* A job the pool cannot queue is never handed back by it */
+      if(!thread_pool_submit(&pool, LoadModel, &jobs[k])){
+        LoadModel(&jobs[k]);
+        cached += ReportModel(&jobs[k]);
       }
     }
  
@@ -712,8 +992,13 @@ void Initialize()
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);    
 
-    /* Setup vertex, color, and index buffer objects */
-    SetupDataBuffers();
+    /* Setup vertex, color, and index buffer objects; GL calls stay
+     * on this thread while the workers are still loading */
+    cached += SetupDataBuffers(&pool);
+    thread_pool_free(&pool);
+
+    printf("Loaded %d models (%d from mesh cache) in %d ms\n", model_count, cached, 
+           glutGet(GLUT_ELAPSED_TIME) - startTime);
 
     /* Setup shaders and shader program */
     CreateShaderProgram();  
@@ -722,17 +1007,20 @@ void Initialize()
     SetIdentityMatrix(ProjectionMatrix);
     SetIdentityMatrix(ViewMatrix);	
   
-    // set all Model matrices       
+    // set all Model matrices from the hierarchy of the mobile
+    BuildScene();
+    UpdateModelMatrices();
+    if(!cull_batch_make(&ModelBounds, model_count)){
+      fprintf(stderr, "Could not create model bounds\n");
+      exit(1);
+    }
     for(k=0; k<model_count; ++k){
-       SetIdentityMatrix(ModelMatrix[k]);
+      if(cull_batch_add(&ModelBounds) < 0){
+        fprintf(stderr, "Could not create model bounds\n");
+        exit(1);
+      }
     }
     
-    /* Initialize animation matrices */
-    SetIdentityMatrix(RotationMatrixAnimX);
-    SetIdentityMatrix(RotationMatrixAnimY);
-    SetIdentityMatrix(RotationMatrixAnimZ);
-    SetIdentityMatrix(RotationMatrixAnim);
-    
     /* Set projection transform */
     SetPerspectiveMatrix(fovy, aspect, nearPlane, farPlane, ProjectionMatrix);
 
@@ -784,6 +1072,7 @@ int main(int argc, char** argv)
     glutDisplayFunc(Display);
     glutKeyboardFunc(Keyboard); 					// NEW re-enable keyboard for camera modes 
     glutMouseFunc(Mouse);  
+    glutCloseFunc(Shutdown);
 
     glutMainLoop();
 
@@ -0,0 +1,392 @@
+/******************************************************************
+*
+* MatrixBench.c
+*
+* Description: Exactness check and microbenchmark of the matrix and
+*              quaternion kernels with a vector path.
+*
+*              Usage: MatrixBench [-w file | -c file]
+*
+*              Every kernel runs on the same generated inputs, random
+*              magnitudes from 1e-4 to 1e4 mixed with entries of -1, 0
+*              and 1 that produce signed zeros. With -w the results
+*              are written to a file; with -c they are compared bit
+*              for bit with such a file and any difference makes the
+*              program fail. The time per call is reported in both
+*              cases, averaged over several runs.
+*
+*              The program is linked once with the scalar Matrix.o
+*              (-DMATRIX_NO_SIMD), which writes the reference, and
+*              with the SSE and default builds, which compare against
+*              it; see the matrix-bench make target.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+
+/* Standard includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Local includes */
+#include "Matrix.h"        /* Kernels under test */
+
+
+/* Inputs per kernel and repetitions of each timed pass */
+#define CASE_COUNT 4096
+#define BENCHMARK_RUNS 200
+
+/* Largest number of floats a kernel writes per case */
+#define MAX_OUTPUT 16
+
+typedef struct
+{
+    const char *name;
+    void (*run)(float *out);    /* all cases, out holds outputs floats each */
+    int outputs;
+} Kernel;
+
+/* Inputs shared by all kernels */
+float Matrices[CASE_COUNT][16];
+float Affine[CASE_COUNT][16];
+float Vectors[CASE_COUNT][4];
+Quaternion Quaternions[CASE_COUNT];
+float Factors[CASE_COUNT];
+
+
+/******************************************************************
+*
+* Seconds
+*
+* Monotonic wall clock time in seconds
+*
+*******************************************************************/
+
+double Seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+
+/******************************************************************
+*
+* MakeInputs
+*
+* Fill the inputs from a fixed seed, so every build sees the same
+* values; odd cases only use -1, 0 and 1
+*
+*******************************************************************/
+
+unsigned int RandomState = 2463534242u;
+
+unsigned int Random()
+{
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 17;
+    RandomState ^= RandomState << 5;
+    return RandomState;
+}
+
+float RandomValue(int small)
+{
+    unsigned int r = Random();
+    float value;
+    int exponent;
+
+    if(small)
+        return (float)((int)(r % 3) - 1);
+
+    /* mantissa in [1, 2), times 10^-4 .. 10^4, either sign */
+    value = 1.0f + (r >> 8) / 16777216.0f;
+    for(exponent = (int)(Random() % 9) - 4; exponent > 0; exponent--)
+        value *= 10.0f;
+    for(; exponent < 0; exponent++)
+        value *= 0.1f;
+
+    return r & 1 ? -value : value;
+}
+
+void MakeInputs()
+{
+    int i, j;
+
+    for(i=0; i<CASE_COUNT; i++){
+        for(j=0; j<16; j++){
+            Matrices[i][j] = RandomValue(i & 1);
+            Affine[i][j] = j < 12 ? RandomValue(i & 1) : (j == 15 ? 1.0f : 0.0f);
+        }
+        for(j=0; j<4; j++)
+            Vectors[i][j] = RandomValue(i & 1);
+
+        Quaternions[i].x = RandomValue(i & 1);
+        Quaternions[i].y = RandomValue(i & 1);
+        Quaternions[i].z = RandomValue(i & 1);
+        Quaternions[i].w = RandomValue(i & 1);
+        if(!(i & 1))
+            NormalizeQuaternion(&Quaternions[i], &Quaternions[i]);
+
+        Factors[i] = (Random() % 1025) / 1024.0f;
+    }
+}
+
+
+/******************************************************************
+*
+* Kernels
+*
+* Each runs one function on all cases; case i pairs input i with
+* input i+1
+*
+*******************************************************************/
+
+#define NEXT(i) (((i) + 1) % CASE_COUNT)
+
+void RunMultiply(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++)
+        MultiplyMatrix(Matrices[i], Matrices[NEXT(i)], out + 16*i);
+}
+
+void RunMultiplyInPlace(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++){
+        memcpy(out + 16*i, Matrices[i], 16*sizeof(float));
+        MultiplyMatrix(out + 16*i, Matrices[NEXT(i)], out + 16*i);
+    }
+}
+
+void RunMultiplyAffine(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++)
+        MultiplyAffineMatrix(Affine[i], Affine[NEXT(i)], out + 16*i);
+}
+
+void RunTranspose(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++)
+        TransposeMatrix(Matrices[i], out + 16*i);
+}
+
+void RunInvertAffine(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++){
+        memset(out + 16*i, 0, 16*sizeof(float));
+        out[16*i + 15] = InvertAffineMatrix(Affine[i], out + 16*i) ? 1.0f : 0.0f;
+    }
+}
+
+void RunTransformVector(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++)
+        TransformVector(Matrices[i], Vectors[i], out + 4*i);
+}
+
+void RunTransformPoints(float *out)
+{
+    int i;
+
+    /* four cases hold five points of 3 floats, one float is left */
+    for(i=0; i<CASE_COUNT; i+=4){
+        out[4*i + 15] = 0.0f;
+        TransformPoints(Affine[i], &Vectors[i][0], 5, out + 4*i);
+    }
+}
+
+void RunMultiplyQuaternion(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++)
+        MultiplyQuaternion(&Quaternions[i], &Quaternions[NEXT(i)], (Quaternion*)(out + 4*i));
+}
+
+void RunNormalizeQuaternion(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++)
+        NormalizeQuaternion(&Quaternions[i], (Quaternion*)(out + 4*i));
+}
+
+void RunNlerpQuaternion(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++)
+        NlerpQuaternion(&Quaternions[i], &Quaternions[NEXT(i)], Factors[i], (Quaternion*)(out + 4*i));
+}
+
+void RunSlerpQuaternion(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++)
+        SlerpQuaternion(&Quaternions[i], &Quaternions[NEXT(i)], Factors[i], (Quaternion*)(out + 4*i));
+}
+
+void RunRotateVectorQuaternion(float *out)
+{
+    int i;
+    for(i=0; i<CASE_COUNT; i++){
+        out[4*i + 3] = 0.0f;
+        RotateVectorQuaternion(&Quaternions[i], Vectors[i], out + 4*i);
+    }
+}
+
+Kernel Kernels[] =
+{
+    {"MultiplyMatrix", RunMultiply, 16},
+    {"MultiplyMatrix in place", RunMultiplyInPlace, 16},
+    {"MultiplyAffineMatrix", RunMultiplyAffine, 16},
+    {"TransposeMatrix", RunTranspose, 16},
+    {"InvertAffineMatrix", RunInvertAffine, 16},
+    {"TransformVector", RunTransformVector, 4},
+    {"TransformPoints", RunTransformPoints, 4},
+    {"MultiplyQuaternion", RunMultiplyQuaternion, 4},
+    {"NormalizeQuaternion", RunNormalizeQuaternion, 4},
+    {"NlerpQuaternion", RunNlerpQuaternion, 4},
+    {"SlerpQuaternion", RunSlerpQuaternion, 4},
+    {"RotateVectorQuaternion", RunRotateVectorQuaternion, 4},
+};
+
+#define KERNEL_COUNT ((int)(sizeof(Kernels)/sizeof(Kernels[0])))
+
+
+/******************************************************************
+*
+* CompareResults
+*
+* Number of cases whose outputs differ in any bit from the
+* reference; the first of them is left in first
+*
+*******************************************************************/
+
+int CompareResults(const Kernel *kernel, const float *result, const float *reference, int *first)
+{
+    int mismatches = 0;
+    int i;
+
+    for(i=0; i<CASE_COUNT; i++){
+        if(memcmp(result + kernel->outputs*i, reference + kernel->outputs*i,
+                  kernel->outputs*sizeof(float)) == 0)
+            continue;
+
+        if(mismatches++ == 0)
+            *first = i;
+    }
+
+    return mismatches;
+}
+
+
+/******************************************************************
+*
+* PrintCase
+*
+* Outputs of one case that differ from the reference, as bits
+*
+*******************************************************************/
+
+void PrintCase(const Kernel *kernel, const float *result, const float *reference, int i)
+{
+    const float *a = result + kernel->outputs*i;
+    const float *b = reference + kernel->outputs*i;
+    unsigned int bits_a, bits_b;
+    int j;
+
+    for(j=0; j<kernel->outputs; j++){
+        memcpy(&bits_a, &a[j], sizeof(bits_a));
+        memcpy(&bits_b, &b[j], sizeof(bits_b));
+        if(bits_a != bits_b)
+            printf("    case %d, output %d: %08x (%g), reference %08x (%g)\n",
+                   i, j, bits_a, a[j], bits_b, b[j]);
+    }
+}
+
+
+/******************************************************************
+*
+* main
+*
+*******************************************************************/
+
+int main(int argc, char** argv)
+{
+    FILE *file = NULL;
+    float *result, *reference;
+    double start, seconds;
+    int writing = 0, failed = 0;
+    int mismatches, first = 0;
+    int k, run;
+
+    if(argc == 3 && strcmp(argv[1], "-w") == 0)
+        writing = 1;
+    else if(!(argc == 1 || (argc == 3 && strcmp(argv[1], "-c") == 0))){
+        fprintf(stderr, "Usage: %s [-w file | -c file]\n", argv[0]);
+        return 1;
+    }
+
+    if(argc == 3 && (file = fopen(argv[2], writing ? "wb" : "rb")) == NULL){
+        fprintf(stderr, "Could not open %s\n", argv[2]);
+        return 1;
+    }
+
+    result = (float*) malloc(sizeof(float) * MAX_OUTPUT * CASE_COUNT);
+    reference = (float*) malloc(sizeof(float) * MAX_OUTPUT * CASE_COUNT);
+    if(result == NULL || reference == NULL){
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    MakeInputs();
+    printf("%s: %d cases, time per call averaged over %d runs\n", argv[0], CASE_COUNT, BENCHMARK_RUNS);
+
+    for(k=0; k<KERNEL_COUNT; k++){
+        start = Seconds();
+        for(run=0; run<BENCHMARK_RUNS; run++)
+            Kernels[k].run(result);
+        seconds = (Seconds() - start) / ((double)BENCHMARK_RUNS * CASE_COUNT);
+
+        printf("%-28s %7.2f ns", Kernels[k].name, seconds*1e9);
+
+        if(file == NULL)
+            printf("\n");
+        else if(writing){
+            fwrite(result, sizeof(float) * Kernels[k].outputs, CASE_COUNT, file);
+            printf("   written\n");
+        }
+        else if(fread(reference, sizeof(float) * Kernels[k].outputs, CASE_COUNT, file) != CASE_COUNT){
+            printf("   reference file too short\n");
+            failed = 1;
+            break;
+        }
+        else{
+            mismatches = CompareResults(&Kernels[k], result, reference, &first);
+            if(mismatches == 0)
+                printf("   identical\n");
+            else{
+                printf("   %d of %d cases DIFFER\n", mismatches, CASE_COUNT);
+                PrintCase(&Kernels[k], result, reference, first);
+                failed = 1;
+            }
+        }
+    }
+
+    if(file != NULL)
+        fclose(file);
+    free(result);
+    free(reference);
+
+    return failed;
+}
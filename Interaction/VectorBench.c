@@ -0,0 +1,328 @@
+/******************************************************************
+*
+* VectorBench.c
+*
+* Description: Microbenchmark of the growable vector against the
+*              pointer list it replaced in the OBJ parser.
+*
+*              Usage: VectorBench [item_count]
+*
+*              For the list every item is allocated from an arena, as
+*              the parser did, and added by pointer; the vector keeps
+*              the items inline. Appending, summing and appending
+*              named items is timed for both, each the median of
+*              several runs. The sums are printed so that both sides
+*              provably did the same work.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+
+/* Standard includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Local includes */
+#include "Arena.h"         /* Storage of the list items */
+#include "List.h"          /* Pointer list */
+#include "Vector.h"        /* Growable inline arrays */
+
+
+/* Number of repetitions, the median of which is reported */
+#define BENCHMARK_RUNS 5
+
+/* Items appended by default; named items are a tenth of them */
+#define DEFAULT_ITEM_COUNT 1000000
+#define NAME_SIZE 32
+
+typedef struct
+{
+    double e[3];
+} Vec3;
+
+VECTOR_DECLARE(Vec3Vector, Vec3)
+
+typedef double (*BenchmarkFunction)(int count, double *checksum);
+
+
+/******************************************************************
+*
+* Seconds
+*
+* Monotonic wall clock time in seconds
+*
+*******************************************************************/
+
+double Seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+
+/******************************************************************
+*
+* ListAppend, VectorAppend
+*
+* Append count vectors, then sum them in order; return the time for
+* appending and leave the sum in checksum
+*
+*******************************************************************/
+
+double ListAppend(int count, double *checksum)
+{
+    list items;
+    arena storage;
+    Vec3 *v;
+    double start, seconds;
+    int i;
+
+    list_make(&items, 10, 1);
+    arena_make(&storage, 0);
+
+    start = Seconds();
+    for(i=0; i<count; i++){
+        v = (Vec3*) arena_alloc(&storage, sizeof(Vec3));
+        v->e[0] = i; v->e[1] = 0.5*i; v->e[2] = 0.25*i;
+        list_add_item(&items, v, NULL);
+    }
+    seconds = Seconds() - start;
+
+    *checksum = 0.0;
+    for(i=0; i<items.item_count; i++)
+        *checksum += ((Vec3*)items.items[i])->e[1];
+
+    list_free(&items);
+    arena_free(&storage);
+    return seconds;
+}
+
+double VectorAppend(int count, double *checksum)
+{
+    Vec3Vector items;
+    Vec3 *v;
+    double start, seconds;
+    int i;
+
+    Vec3Vector_make(&items, 0);
+
+    start = Seconds();
+    for(i=0; i<count; i++){
+        v = Vec3Vector_push(&items);
+        v->e[0] = i; v->e[1] = 0.5*i; v->e[2] = 0.25*i;
+    }
+    seconds = Seconds() - start;
+
+    *checksum = 0.0;
+    for(i=0; i<items.count; i++)
+        *checksum += items.items[i].e[1];
+
+    Vec3Vector_free(&items);
+    return seconds;
+}
+
+
+/******************************************************************
+*
+* ListSum, VectorSum
+*
+* Append count vectors untimed, then return the time for summing
+* them in order
+*
+*******************************************************************/
+
+double ListSum(int count, double *checksum)
+{
+    list items;
+    arena storage;
+    Vec3 *v;
+    double start, seconds;
+    int i;
+
+    list_make(&items, 10, 1);
+    arena_make(&storage, 0);
+
+    for(i=0; i<count; i++){
+        v = (Vec3*) arena_alloc(&storage, sizeof(Vec3));
+        v->e[0] = i; v->e[1] = 0.5*i; v->e[2] = 0.25*i;
+        list_add_item(&items, v, NULL);
+    }
+
+    start = Seconds();
+    *checksum = 0.0;
+    for(i=0; i<items.item_count; i++){
+        v = (Vec3*) items.items[i];
+        *checksum += v->e[0] + v->e[1] + v->e[2];
+    }
+    seconds = Seconds() - start;
+
+    list_free(&items);
+    arena_free(&storage);
+    return seconds;
+}
+
+double VectorSum(int count, double *checksum)
+{
+    Vec3Vector items;
+    Vec3 *v;
+    double start, seconds;
+    int i;
+
+    Vec3Vector_make(&items, 0);
+
+    for(i=0; i<count; i++){
+        v = Vec3Vector_push(&items);
+        v->e[0] = i; v->e[1] = 0.5*i; v->e[2] = 0.25*i;
+    }
+
+    start = Seconds();
+    *checksum = 0.0;
+    for(i=0; i<items.count; i++){
+        v = &items.items[i];
+        *checksum += v->e[0] + v->e[1] + v->e[2];
+    }
+    seconds = Seconds() - start;
+
+    Vec3Vector_free(&items);
+    return seconds;
+}
+
+
+/******************************************************************
+*
+* ListNames, VectorNames
+*
+* Append count named items, as the parser does for materials, and
+* return the time; the checksum is the length of all names stored
+*
+*******************************************************************/
+
+double ListNames(int count, double *checksum)
+{
+    list items;
+    char name[NAME_SIZE];
+    double start, seconds;
+    int i;
+
+    list_make(&items, 10, 1);
+
+    start = Seconds();
+    for(i=0; i<count; i++){
+        snprintf(name, NAME_SIZE, "material_%d", i);
+        list_add_item(&items, NULL, name);
+    }
+    seconds = Seconds() - start;
+
+    *checksum = 0.0;
+    for(i=0; i<items.item_count; i++)
+        *checksum += strlen(items.names[i]);
+
+    list_free(&items);
+    return seconds;
+}
+
+double VectorNames(int count, double *checksum)
+{
+    name_pool names;
+    char name[NAME_SIZE];
+    double start, seconds;
+    int i;
+
+    name_pool_make(&names);
+
+    start = Seconds();
+    for(i=0; i<count; i++){
+        snprintf(name, NAME_SIZE, "material_%d", i);
+        name_pool_add(&names, name);
+    }
+    seconds = Seconds() - start;
+
+    *checksum = 0.0;
+    for(i=0; i<names.offsets.count; i++)
+        *checksum += strlen(name_pool_get(&names, i));
+
+    name_pool_free(&names);
+    return seconds;
+}
+
+
+/******************************************************************
+*
+* Median
+*
+* Median time of several runs of a benchmark
+*
+*******************************************************************/
+
+int CompareSeconds(const void *a, const void *b)
+{
+    double difference = *(const double*)a - *(const double*)b;
+    return (difference > 0.0) - (difference < 0.0);
+}
+
+double Median(BenchmarkFunction function, int count, double *checksum)
+{
+    double seconds[BENCHMARK_RUNS];
+    int i;
+
+    for(i=0; i<BENCHMARK_RUNS; i++)
+        seconds[i] = function(count, checksum);
+
+    qsort(seconds, BENCHMARK_RUNS, sizeof(double), CompareSeconds);
+    return seconds[BENCHMARK_RUNS/2];
+}
+
+
+/******************************************************************
+*
+* Report
+*
+* Time a list and a vector benchmark and print both
+*
+*******************************************************************/
+
+void Report(const char *title, BenchmarkFunction list_function, BenchmarkFunction vector_function, int count)
+{
+    double list_checksum, vector_checksum;
+    double list_time = Median(list_function, count, &list_checksum);
+    double vector_time = Median(vector_function, count, &vector_checksum);
+
+    printf("%-28s %8d   list %8.3f ms   vector %8.3f ms   %5.2fx   (checksum %.0f%s)\n",
+           title, count, list_time*1e3, vector_time*1e3, list_time/vector_time,
+           vector_checksum, list_checksum == vector_checksum ? "" : ", MISMATCH");
+}
+
+
+/******************************************************************
+*
+* main
+*
+*******************************************************************/
+
+int main(int argc, char** argv)
+{
+    int count = DEFAULT_ITEM_COUNT;
+
+    if(argc > 1)
+        count = atoi(argv[1]);
+
+    if(argc > 2 || count <= 0){
+        fprintf(stderr, "Usage: %s [item_count]\n", argv[0]);
+        return 1;
+    }
+
+    printf("median of %d runs\n", BENCHMARK_RUNS);
+    Report("append vec3", ListAppend, VectorAppend, count);
+    Report("sum vec3", ListSum, VectorSum, count);
+    Report("append names", ListNames, VectorNames, count/10 > 0 ? count/10 : 1);
+
+    return 0;
+}
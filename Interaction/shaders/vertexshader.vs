@@ -1,15 +1,16 @@
 #version 330
 
-uniform mat4 ProjectionMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 ModelMatrix;
-
 layout (location = 0) in vec3 Position;
+layout (location = 1) in vec3 Normal;
+
+/* ProjectionMatrix*ViewMatrix*ModelMatrix of the drawn model, one per
+ * instance; its rows arrive as the columns of the attribute */
+layout (location = 2) in mat4 MVPMatrix;
 
 out vec4 vColor;
 
 void main()
 {
-   gl_Position = ProjectionMatrix*ViewMatrix*ModelMatrix*vec4(Position.x, Position.y, Position.z, 1.0);
+   gl_Position = vec4(Position.x, Position.y, Position.z, 1.0)*MVPMatrix;
    vColor = vec4(1.0, 1.0, 1.0, 1.0);
 }
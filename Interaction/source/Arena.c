@@ -0,0 +1,129 @@
+/******************************************************************
+*
+* Arena.c
+*
+* Description: Bump allocator handing out memory from a chain of
+*              large chunks. Individual allocations are never freed;
+*              the whole arena is released at once.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "Arena.h"
+
+#define ARENA_ALIGN(x) (((x) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(arena_chunk))
+
+
+// internal helper functions
+arena_chunk* arena_add_chunk(arena *arena_o, size_t min_size)
+{
+	arena_chunk *chunk;
+	size_t size = arena_o->next_chunk_size;
+
+	//larger requests get a chunk of their own size, doubling up to
+	//them could overflow
+	if(min_size > ARENA_MAX_CHUNK_SIZE)
+		size = min_size;
+	while(size < min_size)
+		size *= 2;
+	if(size > SIZE_MAX - ARENA_HEADER_SIZE)
+		return NULL;
+
+	chunk = (arena_chunk*) malloc(ARENA_HEADER_SIZE + size);
+	if(chunk == NULL)
+		return NULL;
+
+	chunk->next = arena_o->head;
+	chunk->size = size;
+	chunk->used = 0;
+	arena_o->head = chunk;
+	arena_o->total_size += size;
+
+	//grow geometrically so a load only needs a handful of chunks
+	if(arena_o->next_chunk_size < ARENA_MAX_CHUNK_SIZE)
+		arena_o->next_chunk_size *= 2;
+
+	return chunk;
+}
+//end helpers
+
+void arena_make(arena *arena_o, size_t start_size)
+{
+	arena_o->head = NULL;
+	arena_o->total_size = 0;
+	arena_o->next_chunk_size = start_size < ARENA_MIN_CHUNK_SIZE ? ARENA_MIN_CHUNK_SIZE : start_size;
+}
+
+void* arena_alloc(arena *arena_o, size_t size)
+{
+	arena_chunk *chunk = arena_o->head;
+	void *memory;
+
+	if(size > SIZE_MAX - ARENA_ALIGNMENT)
+		return NULL;
+	size = ARENA_ALIGN(size);
+
+	if(chunk == NULL || chunk->size - chunk->used < size)
+	{
+		chunk = arena_add_chunk(arena_o, size);
+		if(chunk == NULL)
+			return NULL;
+	}
+
+	memory = (char*)chunk + ARENA_HEADER_SIZE + chunk->used;
+	chunk->used += size;
+
+	return memory;
+}
+
+void arena_adopt(arena *arena_o, arena *other)
+{
+	arena_chunk *last = other->head;
+
+	if(last == NULL)
+		return;
+
+	//keep the current head so bump allocation continues where it was
+	while(last->next != NULL)
+		last = last->next;
+
+	if(arena_o->head == NULL)
+	{
+		arena_o->head = other->head;
+	}
+	else
+	{
+		last->next = arena_o->head->next;
+		arena_o->head->next = other->head;
+	}
+
+	arena_o->total_size += other->total_size;
+	other->head = NULL;
+	other->total_size = 0;
+}
+
+void arena_free(arena *arena_o)
+{
+	arena_chunk *chunk = arena_o->head;
+	arena_chunk *next;
+
+	while(chunk != NULL)
+	{
+		next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+
+	arena_o->head = NULL;
+	arena_o->total_size = 0;
+}
@@ -0,0 +1,45 @@
+/******************************************************************
+*
+* Arena.h
+*
+* Description: Bump allocator handing out memory from a chain of
+*              large chunks. Individual allocations are never freed;
+*              the whole arena is released at once.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_ALIGNMENT 8
+#define ARENA_MIN_CHUNK_SIZE (64*1024)
+#define ARENA_MAX_CHUNK_SIZE (16*1024*1024)
+
+typedef struct arena_chunk
+{
+	struct arena_chunk *next;
+	size_t size;
+	size_t used;
+} arena_chunk;
+
+typedef struct
+{
+	arena_chunk *head;
+	size_t next_chunk_size;
+	size_t total_size;
+} arena;
+
+void arena_make(arena *arena_o, size_t start_size);
+void* arena_alloc(arena *arena_o, size_t size);
+void arena_adopt(arena *arena_o, arena *other);
+void arena_free(arena *arena_o);
+
+#endif
@@ -0,0 +1,291 @@
+/******************************************************************
+*
+* Cull.c
+*
+* Description: Frustum planes of a view projection matrix and a
+*              plane test of world bounds, four objects at a time.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "Cull.h"
+
+#if defined(__SSE__) && !defined(MATRIX_NO_SIMD)
+#define CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+#define CULL_COMPONENTS 10
+
+
+// internal helper functions
+double cull_seconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+int cull_batch_reserve(cull_batch *batch, int capacity)
+{
+	float *storage;
+	float **arrays[CULL_COMPONENTS];
+	unsigned char *visible;
+	int i;
+
+	if(capacity <= batch->capacity)
+		return 1;
+
+	//whole groups of four, so the vector loads never leave an array;
+	//zeroed, so the padding holds no NaNs
+	capacity = (capacity + 3) & ~3;
+	storage = (float*) calloc(1, sizeof(float) * CULL_COMPONENTS * capacity + capacity);
+	if(storage == NULL)
+		return 0;
+
+	arrays[0] = &batch->sphere_x;
+	arrays[1] = &batch->sphere_y;
+	arrays[2] = &batch->sphere_z;
+	arrays[3] = &batch->radius;
+	arrays[4] = &batch->box_x;
+	arrays[5] = &batch->box_y;
+	arrays[6] = &batch->box_z;
+	arrays[7] = &batch->extent_x;
+	arrays[8] = &batch->extent_y;
+	arrays[9] = &batch->extent_z;
+
+	for(i=0; i<CULL_COMPONENTS; i++)
+	{
+		if(batch->count > 0)
+			memcpy(storage + i*capacity, *arrays[i], sizeof(float) * batch->count);
+		*arrays[i] = storage + i*capacity;
+	}
+
+	visible = (unsigned char*)(storage + CULL_COMPONENTS*capacity);
+	if(batch->count > 0)
+		memcpy(visible, batch->visible, batch->count);
+	batch->visible = visible;
+
+	free(batch->storage);
+	batch->storage = storage;
+	batch->capacity = capacity;
+	return 1;
+}
+
+#ifdef CULL_SSE
+/* Bit i set if object first + i lies outside a plane */
+int cull_test_four(const cull_batch *batch, const cull_frustum *frustum, int first)
+{
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+	__m128 sphere_x = _mm_loadu_ps(batch->sphere_x + first);
+	__m128 sphere_y = _mm_loadu_ps(batch->sphere_y + first);
+	__m128 sphere_z = _mm_loadu_ps(batch->sphere_z + first);
+	__m128 radius = _mm_loadu_ps(batch->radius + first);
+	__m128 box_x = _mm_loadu_ps(batch->box_x + first);
+	__m128 box_y = _mm_loadu_ps(batch->box_y + first);
+	__m128 box_z = _mm_loadu_ps(batch->box_z + first);
+	__m128 extent_x = _mm_loadu_ps(batch->extent_x + first);
+	__m128 extent_y = _mm_loadu_ps(batch->extent_y + first);
+	__m128 extent_z = _mm_loadu_ps(batch->extent_z + first);
+	__m128 outside = _mm_setzero_ps();
+	__m128 a, b, c, d, distance, reach;
+	int i;
+
+	for(i=0; i<6; i++)
+	{
+		a = _mm_set1_ps(frustum->planes[i][0]);
+		b = _mm_set1_ps(frustum->planes[i][1]);
+		c = _mm_set1_ps(frustum->planes[i][2]);
+		d = _mm_set1_ps(frustum->planes[i][3]);
+
+		//sphere: center farther than the radius behind the plane
+		distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, sphere_x), _mm_mul_ps(b, sphere_y)),
+		                      _mm_add_ps(_mm_mul_ps(c, sphere_z), d));
+		outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+
+		//box: middle farther behind than the extent along the normal
+		distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, box_x), _mm_mul_ps(b, box_y)),
+		                      _mm_add_ps(_mm_mul_ps(c, box_z), d));
+		reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, a), extent_x),
+		                              _mm_mul_ps(_mm_andnot_ps(sign_mask, b), extent_y)),
+		                   _mm_mul_ps(_mm_andnot_ps(sign_mask, c), extent_z));
+		outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+	}
+
+	return _mm_movemask_ps(outside);
+}
+#else
+int cull_test_one(const cull_batch *batch, const cull_frustum *frustum, int i)
+{
+	const float *plane;
+	float distance, reach;
+	int k;
+
+	for(k=0; k<6; k++)
+	{
+		plane = frustum->planes[k];
+
+		distance = plane[0]*batch->sphere_x[i] + plane[1]*batch->sphere_y[i] + plane[2]*batch->sphere_z[i] + plane[3];
+		if(distance + batch->radius[i] < 0.0f)
+			return 1;
+
+		distance = plane[0]*batch->box_x[i] + plane[1]*batch->box_y[i] + plane[2]*batch->box_z[i] + plane[3];
+		reach = fabsf(plane[0])*batch->extent_x[i] + fabsf(plane[1])*batch->extent_y[i] +
+		        fabsf(plane[2])*batch->extent_z[i];
+		if(distance + reach < 0.0f)
+			return 1;
+	}
+
+	return 0;
+}
+#endif
+//end helpers
+
+
+/* Planes of the frustum of a row-major projection * view matrix, as
+ * sums and differences of its rows (Gribb and Hartmann) */
+void cull_frustum_make(const float *view_projection, cull_frustum *frustum)
+{
+	const float *w = view_projection + 12;
+	float *plane, length;
+	int i, j;
+
+	for(i=0; i<6; i++)
+	{
+		plane = frustum->planes[i];
+		for(j=0; j<4; j++)
+		{
+			if(i % 2 == 0)
+				plane[j] = w[j] + view_projection[4*(i/2) + j];
+			else
+				plane[j] = w[j] - view_projection[4*(i/2) + j];
+		}
+
+		length = sqrtf(plane[0]*plane[0] + plane[1]*plane[1] + plane[2]*plane[2]);
+		if(length > 0.0f)
+			for(j=0; j<4; j++)
+				plane[j] /= length;
+	}
+}
+
+int cull_batch_make(cull_batch *batch, int capacity)
+{
+	memset(batch, 0, sizeof(cull_batch));
+	if(capacity < 4)
+		capacity = 4;
+	return cull_batch_reserve(batch, capacity);
+}
+
+/* Append an object with empty bounds at the origin; returns its
+ * index or -1 */
+int cull_batch_add(cull_batch *batch)
+{
+	int i = batch->count;
+
+	if(i == batch->capacity && !cull_batch_reserve(batch, batch->capacity*2))
+		return -1;
+
+	batch->sphere_x[i] = batch->sphere_y[i] = batch->sphere_z[i] = 0.0f;
+	batch->radius[i] = 0.0f;
+	batch->box_x[i] = batch->box_y[i] = batch->box_z[i] = 0.0f;
+	batch->extent_x[i] = batch->extent_y[i] = batch->extent_z[i] = 0.0f;
+	batch->visible[i] = 1;
+
+	batch->count++;
+	return i;
+}
+
+/* World bounds of a mesh placed by a row-major model matrix: the
+ * sphere grows with the longest axis of the matrix, the box becomes
+ * the box around the transformed box (Arvo) */
+void cull_batch_set(cull_batch *batch, int index, const mesh_bounds *bounds, const float *model_matrix)
+{
+	float middle[3], half[3], world[3], extent[3];
+	float scale = 0.0f, column;
+	const float *row;
+	int i, j;
+
+	for(j=0; j<3; j++)
+	{
+		middle[j] = 0.5f * (bounds->min[j] + bounds->max[j]);
+		half[j] = 0.5f * (bounds->max[j] - bounds->min[j]);
+		column = model_matrix[j]*model_matrix[j] + model_matrix[4+j]*model_matrix[4+j] +
+		         model_matrix[8+j]*model_matrix[8+j];
+		if(column > scale)
+			scale = column;
+	}
+
+	for(i=0; i<3; i++)
+	{
+		row = model_matrix + 4*i;
+		world[i] = row[0]*bounds->center[0] + row[1]*bounds->center[1] + row[2]*bounds->center[2] + row[3];
+		extent[i] = fabsf(row[0])*half[0] + fabsf(row[1])*half[1] + fabsf(row[2])*half[2];
+	}
+	batch->sphere_x[index] = world[0];
+	batch->sphere_y[index] = world[1];
+	batch->sphere_z[index] = world[2];
+	batch->radius[index] = bounds->radius * sqrtf(scale);
+
+	for(i=0; i<3; i++)
+	{
+		row = model_matrix + 4*i;
+		world[i] = row[0]*middle[0] + row[1]*middle[1] + row[2]*middle[2] + row[3];
+	}
+	batch->box_x[index] = world[0];
+	batch->box_y[index] = world[1];
+	batch->box_z[index] = world[2];
+	batch->extent_x[index] = extent[0];
+	batch->extent_y[index] = extent[1];
+	batch->extent_z[index] = extent[2];
+}
+
+/* Set visible for every object and the statistics; returns the
+ * number of visible objects */
+int cull_batch_test(cull_batch *batch, const cull_frustum *frustum)
+{
+	double start = cull_seconds();
+	int visible_count = 0;
+	int i;
+#ifdef CULL_SSE
+	int outside, k;
+
+	for(i=0; i<batch->count; i+=4)
+	{
+		//the padding past count is tested as well, but never read
+		outside = cull_test_four(batch, frustum, i);
+		for(k=0; k<4 && i+k<batch->count; k++)
+		{
+			batch->visible[i+k] = !(outside & (1 << k));
+			visible_count += batch->visible[i+k];
+		}
+	}
+#else
+	for(i=0; i<batch->count; i++)
+	{
+		batch->visible[i] = !cull_test_one(batch, frustum, i);
+		visible_count += batch->visible[i];
+	}
+#endif
+
+	batch->visible_count = visible_count;
+	batch->culled_count = batch->count - visible_count;
+	batch->seconds = cull_seconds() - start;
+	return visible_count;
+}
+
+void cull_batch_free(cull_batch *batch)
+{
+	free(batch->storage);
+	memset(batch, 0, sizeof(cull_batch));
+}
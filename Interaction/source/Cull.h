@@ -0,0 +1,69 @@
+/******************************************************************
+*
+* Cull.h
+*
+* Description: View frustum culling of objects by their bounds.
+*
+*              The bounds of every object are kept in world space,
+*              one array per component: the bounding sphere and the
+*              axis aligned box around the transformed mesh box. An
+*              object is culled if either lies completely outside
+*              one of the six frustum planes. Four objects are
+*              tested at a time with SSE; objects crossing a plane
+*              corner may be kept although they are not visible,
+*              but no visible object is ever culled.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __CULL_H
+#define __CULL_H
+
+#include "Mesh.h"
+
+/* Planes as a, b, c, d with ax + by + cz + d >= 0 inside and a unit
+ * normal, so d is a distance: left, right, bottom, top, near, far */
+typedef struct
+{
+	float planes[6][4];
+} cull_frustum;
+
+typedef struct
+{
+	float *sphere_x;            //world bounding spheres
+	float *sphere_y;
+	float *sphere_z;
+	float *radius;
+	float *box_x;               //middle of the world boxes
+	float *box_y;
+	float *box_z;
+	float *extent_x;            //half the size of the world boxes
+	float *extent_y;
+	float *extent_z;
+	unsigned char *visible;     //result of the last test
+
+	int count;
+	int capacity;
+
+	//statistics of the last test
+	int visible_count;
+	int culled_count;
+	double seconds;
+
+	void *storage;              //single block the arrays point into
+} cull_batch;
+
+void cull_frustum_make(const float *view_projection, cull_frustum *frustum);
+
+int cull_batch_make(cull_batch *batch, int capacity);
+int cull_batch_add(cull_batch *batch);
+void cull_batch_set(cull_batch *batch, int index, const mesh_bounds *bounds, const float *model_matrix);
+int cull_batch_test(cull_batch *batch, const cull_frustum *frustum);
+void cull_batch_free(cull_batch *batch);
+
+#endif
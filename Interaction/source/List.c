@@ -20,6 +20,8 @@
 
 #include "List.h"
 
+#define LIST_SLOT_EMPTY -1
+
 
 
 // internal helper functions
@@ -28,24 +30,101 @@ char list_is_full(list *listo)
 	return(listo->item_count == listo->current_max_size);
 }
 
-void list_grow(list *old_listo)
+unsigned int list_hash_name(const char *name)
+{
+	unsigned int hash = 2166136261u;
+
+	while(*name != '\0')
+		hash = (hash ^ (unsigned char)*name++) * 16777619u;
+	return hash;
+}
+
+void list_index_insert(list *listo, int indx)
+{
+	unsigned int slot;
+
+	if(listo->names[indx] == NULL)
+		return;
+
+	slot = listo->name_hashes[indx] & (listo->name_slot_count - 1);
+	while(listo->name_slots[slot] != LIST_SLOT_EMPTY)
+		slot = (slot + 1) & (listo->name_slot_count - 1);
+
+	listo->name_slots[slot] = indx;
+}
+
+char list_index_rebuild(list *listo)
 {
 	int i;
-	list new_listo;
-	
-	list_make(&new_listo, old_listo->current_max_size*2, old_listo->growable++);
-	
-	for(i=0; i<old_listo->current_max_size; i++)
-		list_add_item(&new_listo, old_listo->items[i] , old_listo->names[i]);
-	
-	list_free(old_listo);
-	
-	//copy new structure to old list
-	old_listo->names = new_listo.names;
-	old_listo->items = new_listo.items;
-	old_listo->item_count = new_listo.item_count;
-	old_listo->current_max_size = new_listo.current_max_size;
-	old_listo->growable = new_listo.growable;
+	int *new_slots;
+	int slot_count = 16;
+
+	//at most half full
+	while(slot_count < listo->current_max_size*2)
+		slot_count *= 2;
+
+	if(slot_count != listo->name_slot_count)
+	{
+		new_slots = (int*) realloc(listo->name_slots, sizeof(int) * slot_count);
+		if(new_slots == NULL)
+			return 0;
+		listo->name_slots = new_slots;
+		listo->name_slot_count = slot_count;
+	}
+
+	for(i=0; i<listo->name_slot_count; i++)
+		listo->name_slots[i] = LIST_SLOT_EMPTY;
+	for(i=0; i<listo->item_count; i++)
+		list_index_insert(listo, i);
+
+	return 1;
+}
+
+int list_index_find(list *listo, const char *name)
+{
+	unsigned int hash = list_hash_name(name);
+	unsigned int slot;
+	int indx;
+
+	for(slot = hash & (listo->name_slot_count - 1); 
+	    (indx = listo->name_slots[slot]) != LIST_SLOT_EMPTY; 
+	    slot = (slot + 1) & (listo->name_slot_count - 1))
+	{
+		if(listo->name_hashes[indx] == hash && strcmp(listo->names[indx], name) == 0)
+			return indx;
+	}
+
+	return -1;
+}
+
+char list_grow(list *listo)
+{
+	int new_size = listo->current_max_size > 0 ? listo->current_max_size*2 : 10;
+	void **new_items;
+	char **new_names;
+	unsigned int *new_hashes;
+
+	//item and name pointers move over, names are not copied again
+	new_items = (void**) realloc(listo->items, sizeof(void*) * new_size);
+	if(new_items == NULL)
+		return 0;
+	listo->items = new_items;
+
+	new_names = (char**) realloc(listo->names, sizeof(char*) * new_size);
+	if(new_names == NULL)
+		return 0;
+	listo->names = new_names;
+
+	if(listo->name_slots != NULL)
+	{
+		new_hashes = (unsigned int*) realloc(listo->name_hashes, sizeof(unsigned int) * new_size);
+		if(new_hashes == NULL)
+			return 0;
+		listo->name_hashes = new_hashes;
+	}
+
+	listo->current_max_size = new_size;
+	return(listo->name_slots == NULL || list_index_rebuild(listo));
 }
 //end helpers
 
@@ -56,6 +135,31 @@ void list_make(list *listo, int start_size, char growable)
 	listo->item_count = 0;
 	listo->current_max_size = start_size;
 	listo->growable = growable;
+	listo->name_slots = NULL;
+	listo->name_hashes = NULL;
+	listo->name_slot_count = 0;
+}
+
+void list_index_names(list *listo)
+{
+	int i;
+
+	if(listo->name_slots != NULL)
+		return;
+
+	listo->name_hashes = (unsigned int*) malloc(sizeof(unsigned int) * (listo->current_max_size + 1));
+	if(listo->name_hashes == NULL)
+		return;
+
+	for(i=0; i<listo->item_count; i++)
+		if(listo->names[i] != NULL)
+			listo->name_hashes[i] = list_hash_name(listo->names[i]);
+
+	if(!list_index_rebuild(listo))
+	{
+		free(listo->name_hashes);
+		listo->name_hashes = NULL;
+	}
 }
 
 int list_add_item(list *listo, void *item, char *name)
@@ -65,9 +169,7 @@ int list_add_item(list *listo, void *item, char *name)
 	
 	if( list_is_full(listo) )
 	{
-		if( listo->growable )
-			list_grow(listo);
-		else
+		if( !listo->growable || !list_grow(listo) )
 			return -1;
 	}
 	
@@ -76,12 +178,18 @@ int list_add_item(list *listo, void *item, char *name)
 	{
 		name_length = strlen(name);
 		new_name = (char*) malloc(sizeof(char) * name_length + 1);
-		strncpy(new_name, name, name_length);
+		memcpy(new_name, name, name_length + 1);
 		listo->names[listo->item_count] = new_name;
 	}
 
 	listo->items[listo->item_count] = item;
 	listo->item_count++;
+
+	if(listo->name_slots != NULL && name != NULL)
+	{
+		listo->name_hashes[listo->item_count-1] = list_hash_name(name);
+		list_index_insert(listo, listo->item_count-1);
+	}
 	
 	return listo->item_count-1;
 }
@@ -120,24 +228,23 @@ void* list_get_item(list *listo, void *item_to_find)
 
 void* list_get_name(list *listo, char *name_to_find)
 {
-	int i = 0;
+	int i = list_find(listo, name_to_find);
 
-	for(i=0; i < listo->item_count; i++)
-	{
-		if(strncmp(listo->names[i], name_to_find, strlen(name_to_find)) == 0)
-			return listo->items[i];
-	}
-	
-	return NULL;
+	if(i < 0)
+		return NULL;
+	return listo->items[i];
 }
 
 int list_find(list *listo, char *name_to_find)
 {
 	int i = 0;
 
+	if(listo->name_slots != NULL)
+		return list_index_find(listo, name_to_find);
+
 	for(i=0; i < listo->item_count; i++)
 	{
-		if(strncmp(listo->names[i], name_to_find, strlen(name_to_find)) == 0)
+		if(listo->names[i] != NULL && strcmp(listo->names[i], name_to_find) == 0)
 			return i;
 	}
 	
@@ -148,7 +255,7 @@ void list_delete_item(list *listo, void *item)
 {
 	int i;
 	
-	for(i=0; i < listo->item_count; i++)
+	for(i=listo->item_count-1; i >= 0; i--)
 	{		
 		if( listo->items[i] == item )
 			list_delete_index(listo, i);
@@ -158,20 +265,13 @@ void list_delete_item(list *listo, void *item)
 void list_delete_name(list *listo, char *name)
 {
 	int i;
-	//int j;
-	//char remove = 0;
-	
-	//	int length_name = strlen(name);
-	int item_name;
 	
 	if(name == NULL)
 		return;
 	
-	for(i=0; i < listo->item_count; i++)
+	for(i=listo->item_count-1; i >= 0; i--)
 	{
-		item_name = strlen(name);
-				
-		if( name != NULL && (strncmp(listo->names[i], name, strlen(name)) == 0) )
+		if( listo->names[i] != NULL && strcmp(listo->names[i], name) == 0 )
 			list_delete_index(listo, i);
 	}
 }
@@ -189,9 +289,15 @@ void list_delete_index(list *listo, int indx)
 	{
 		listo->names[j] = listo->names[j+1];
 		listo->items[j] = listo->items[j+1];
+		if(listo->name_slots != NULL)
+			listo->name_hashes[j] = listo->name_hashes[j+1];
 	}
 	
 	listo->item_count--;
+
+	//later items moved down, so their slots are rebuilt
+	if(listo->name_slots != NULL)
+		list_index_rebuild(listo);
 	
 	return;
 }
@@ -201,7 +307,11 @@ void list_delete_all(list *listo)
 	int i;
 	
 	for(i=listo->item_count-1; i>=0; i--)
-		list_delete_index(listo, i);
+		free(listo->names[i]);
+	listo->item_count = 0;
+
+	for(i=0; i<listo->name_slot_count; i++)
+		listo->name_slots[i] = LIST_SLOT_EMPTY;
 }
 
 void list_free(list *listo)
@@ -209,6 +319,11 @@ void list_free(list *listo)
 	list_delete_all(listo);
 	free(listo->names);
 	free(listo->items);
+	free(listo->name_slots);
+	free(listo->name_hashes);
+	listo->name_slots = NULL;
+	listo->name_hashes = NULL;
+	listo->name_slot_count = 0;
 }
 
 void list_print_list(list *listo)
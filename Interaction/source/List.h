@@ -24,9 +24,15 @@ typedef struct
 
 	void **items;
 	char **names;	
+
+	//optional hash index of the names, see list_index_names
+	int *name_slots;
+	unsigned int *name_hashes;
+	int name_slot_count;
 } list;
 
 void list_make(list *listo, int size, char growable);
+void list_index_names(list *listo);
 int list_add_item(list *listo, void *item, char *name);
 char* list_print_items(list *listo);
 void* list_get_name(list *listo, char *name);
@@ -13,12 +13,115 @@
 *
 *******************************************************************/
 
+#define _GNU_SOURCE         /* sincosf */
+
 /* Standard includes */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
+#include "Matrix.h"
+
+#if defined(__SSE__) && !defined(MATRIX_NO_SIMD)
+#define MATRIX_SSE
+#include <xmmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(MATRIX_NO_AVX)
+#define MATRIX_AVX                  /* selected at run time */
+#include <immintrin.h>
+#endif
+#endif
+
+/* Products and sums are evaluated in the same order in the scalar and
+ * in the vector code, so all paths give identical results */
+
+#ifdef MATRIX_SSE
+#define MATRIX_SPLAT(v, i) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(i, i, i, i))
+#define MATRIX_YZXW(v) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(3, 0, 2, 1))
+#define MATRIX_ZXYW(v) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(3, 1, 0, 2))
+
+/* Row a of a product with the matrix with rows b0 .. b3 */
+#define MATRIX_ROW_PRODUCT(a, b0, b1, b2, b3)                                   \
+    _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(MATRIX_SPLAT(a, 0), (b0)),      \
+                                     _mm_mul_ps(MATRIX_SPLAT(a, 1), (b1))),     \
+                          _mm_mul_ps(MATRIX_SPLAT(a, 2), (b2))),                \
+               _mm_mul_ps(MATRIX_SPLAT(a, 3), (b3)))
+
+static inline __m128 MatrixCross(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(MATRIX_YZXW(a), MATRIX_ZXYW(b)),
+                      _mm_mul_ps(MATRIX_ZXYW(a), MATRIX_YZXW(b)));
+}
+
+/* Row a of an affine product; the translation of a is added in the
+ * last lane only, as adding +0.0 to the others would turn a -0.0 sum
+ * into +0.0 */
+static inline __m128 MatrixAffineRow(__m128 a, __m128 b0, __m128 b1, __m128 b2, __m128 w_mask)
+{
+    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(MATRIX_SPLAT(a, 0), b0),
+                                       _mm_mul_ps(MATRIX_SPLAT(a, 1), b1)),
+                            _mm_mul_ps(MATRIX_SPLAT(a, 2), b2));
+
+    return _mm_or_ps(_mm_and_ps(w_mask, _mm_add_ps(sum, a)), _mm_andnot_ps(w_mask, sum));
+}
+#endif
+
+#ifdef MATRIX_AVX
+static int MatrixHasAVX()
+{
+    static int has_avx = -1;
+
+    if(has_avx < 0)
+        has_avx = __builtin_cpu_supports("avx") ? 1 : 0;
+    return has_avx;
+}
+
+/* Two rows of the result per instruction */
+__attribute__((target("avx")))
+static void MultiplyMatrixAVX(float* m1, float* m2, float* result)
+{
+    __m128 row;
+    __m256 b0, b1, b2, b3, a01, a23, r01, r23;
+
+    row = _mm_loadu_ps(&m2[0]);  b0 = _mm256_insertf128_ps(_mm256_castps128_ps256(row), row, 1);
+    row = _mm_loadu_ps(&m2[4]);  b1 = _mm256_insertf128_ps(_mm256_castps128_ps256(row), row, 1);
+    row = _mm_loadu_ps(&m2[8]);  b2 = _mm256_insertf128_ps(_mm256_castps128_ps256(row), row, 1);
+    row = _mm_loadu_ps(&m2[12]); b3 = _mm256_insertf128_ps(_mm256_castps128_ps256(row), row, 1);
+
+    a01 = _mm256_loadu_ps(&m1[0]);
+    a23 = _mm256_loadu_ps(&m1[8]);
+
+    r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xAA), b2));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xFF), b3));
+
+    r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xAA), b2));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xFF), b3));
+
+    _mm256_storeu_ps(&result[0], r01);
+    _mm256_storeu_ps(&result[8], r23);
+}
+#endif
+
+/* Sine and cosine of an angle in degrees, evaluated together */
+static inline void MatrixSinCos(float angle, float* s, float* c)
+{
+    angle = M_PI/180 * angle;   /* Conversion angle from degree to radians */
+
+#ifdef __GLIBC__
+    sincosf(angle, s, c);
+#else
+    *s = sinf(angle);
+    *c = cosf(angle);
+#endif
+}
+
+/* Writes the last row of an affine matrix */
+#define MATRIX_AFFINE_ROW(m) ((m)[12] = 0.0, (m)[13] = 0.0, (m)[14] = 0.0, (m)[15] = 1.0)
+
 /******************************************************************
 *
 * SetIdentityMatrix
@@ -46,17 +149,14 @@ void SetIdentityMatrix(float* result)
 
 void SetRotationX(float anglex, float* result)
 {
-    anglex = M_PI/180 * anglex;   /* Conversion angle from degree to radians */
+    float s, c;
 
-    float temp[16] = 
-    {  
-        1.0,           0.0,          0.0, 0.0,
-	0.0,  cosf(anglex),-sinf(anglex), 0.0,
-	0.0,  sinf(anglex), cosf(anglex), 0.0,
-	0.0,           0.0,          0.0, 1.0  
-    };
+    MatrixSinCos(anglex, &s, &c);
 
-    memcpy(result, temp, 16*sizeof(float));
+    result[0] = 1.0;  result[1] = 0.0;  result[2] = 0.0;  result[3] = 0.0;
+    result[4] = 0.0;  result[5] = c;    result[6] = -s;   result[7] = 0.0;
+    result[8] = 0.0;  result[9] = s;    result[10] = c;   result[11] = 0.0;
+    MATRIX_AFFINE_ROW(result);
 }
 
 
@@ -68,17 +168,14 @@ void SetRotationX(float anglex, float* result)
 
 void SetRotationY(float angley, float* result)
 {
-    angley = M_PI/180 * angley;   /* Conversion angle from degree to radians */
+    float s, c;
 
-    float temp[16] = 
-    {
-        cosf(angley),  0.0,   sinf(angley),  0.0,
-	         0.0,  1.0,            0.0,  0.0,
-       -sinf(angley),  0.0,   cosf(angley),  0.0,
-	         0.0,  0.0,            0.0,  1.0   
-    };
-  
-    memcpy(result, temp, 16*sizeof(float));
+    MatrixSinCos(angley, &s, &c);
+
+    result[0] = c;    result[1] = 0.0;  result[2] = s;    result[3] = 0.0;
+    result[4] = 0.0;  result[5] = 1.0;  result[6] = 0.0;  result[7] = 0.0;
+    result[8] = -s;   result[9] = 0.0;  result[10] = c;   result[11] = 0.0;
+    MATRIX_AFFINE_ROW(result);
 }
 
 
@@ -90,17 +187,14 @@ void SetRotationY(float angley, float* result)
 
 void SetRotationZ(float anglez, float* result)
 {
-    anglez = M_PI/180 * anglez;   /* Conversion angle from degree to radian */
+    float s, c;
 
-    float temp[16] = 
-    {	
-        cosf(anglez), -sinf(anglez),  0.0,  0.0,
-        sinf(anglez),  cosf(anglez),  0.0,  0.0,          
-                 0.0,           0.0,  1.0,  0.0,
-                 0.0,           0.0,  0.0,  1.0   
-    };
+    MatrixSinCos(anglez, &s, &c);
 
-    memcpy(result, temp, 16*sizeof(float));
+    result[0] = c;    result[1] = -s;   result[2] = 0.0;  result[3] = 0.0;
+    result[4] = s;    result[5] = c;    result[6] = 0.0;  result[7] = 0.0;
+    result[8] = 0.0;  result[9] = 0.0;  result[10] = 1.0; result[11] = 0.0;
+    MATRIX_AFFINE_ROW(result);
 }
 
 
@@ -124,6 +218,105 @@ void SetTranslation(float x, float y, float z, float* result)
 }
 
 
+/******************************************************************
+*
+* SetTransformMatrix
+*
+* Translation * rotation about Y * X * Z * scale in one step, with
+* the angles in degrees
+*
+*******************************************************************/
+
+void SetTransformMatrix(float x, float y, float z,
+                        float anglex, float angley, float anglez,
+                        float scalex, float scaley, float scalez, float* result)
+{
+    float sx, cx, sy, cy, sz, cz;
+
+    MatrixSinCos(anglex, &sx, &cx);
+    MatrixSinCos(angley, &sy, &cy);
+    MatrixSinCos(anglez, &sz, &cz);
+
+    result[0] = (cy*cz + sy*sz*sx)*scalex;
+    result[1] = (sy*cz*sx - cy*sz)*scaley;
+    result[2] = sy*cx*scalez;
+    result[3] = x;
+    result[4] = cx*sz*scalex;
+    result[5] = cx*cz*scaley;
+    result[6] = -sx*scalez;
+    result[7] = y;
+    result[8] = (cy*sz*sx - sy*cz)*scalex;
+    result[9] = (sy*sz + cy*cz*sx)*scaley;
+    result[10] = cy*cx*scalez;
+    result[11] = z;
+    MATRIX_AFFINE_ROW(result);
+}
+
+
+/******************************************************************
+*
+* TranslateMatrix
+*
+* m = m * translation, computing only the changed column
+*
+*******************************************************************/
+
+void TranslateMatrix(float* m, float x, float y, float z)
+{
+    int i;
+
+    for (i = 0; i < 16; i += 4)
+        m[i + 3] = m[i]*x + m[i + 1]*y + m[i + 2]*z + m[i + 3];
+}
+
+
+/******************************************************************
+*
+* RotateMatrixX/Y/Z
+*
+* m = m * rotation, computing only the two changed columns
+*
+*******************************************************************/
+
+/* Columns a and b of m after multiplying with a plane rotation */
+static inline void MatrixRotateColumns(float* m, int a, int b, float s, float c)
+{
+    float ma, mb;
+    int i;
+
+    for (i = 0; i < 16; i += 4){
+        ma = m[i + a];
+        mb = m[i + b];
+        m[i + a] = ma*c + mb*s;
+        m[i + b] = mb*c - ma*s;
+    }
+}
+
+void RotateMatrixX(float* m, float anglex)
+{
+    float s, c;
+
+    MatrixSinCos(anglex, &s, &c);
+    MatrixRotateColumns(m, 1, 2, s, c);
+}
+
+void RotateMatrixY(float* m, float angley)
+{
+    float s, c;
+
+    MatrixSinCos(angley, &s, &c);
+    MatrixRotateColumns(m, 2, 0, s, c);
+}
+
+void RotateMatrixZ(float* m, float anglez)
+{
+    float s, c;
+
+    MatrixSinCos(anglez, &s, &c);
+    MatrixRotateColumns(m, 0, 1, s, c);
+}
+
+
 /******************************************************************
 *
 * MultiplyMatrix
@@ -132,12 +325,36 @@ void SetTranslation(float x, float y, float z, float* result)
 
 void MultiplyMatrix(float* m1, float* m2, float* result)
 {
-    int i;
+#ifdef MATRIX_AVX
+    if(MatrixHasAVX()){
+        MultiplyMatrixAVX(m1, m2, result);
+        return;
+    }
+#endif
+
+#ifdef MATRIX_SSE
+    /* All rows are loaded before storing, so result may alias m1 or m2 */
+    __m128 b0 = _mm_loadu_ps(&m2[0]);
+    __m128 b1 = _mm_loadu_ps(&m2[4]);
+    __m128 b2 = _mm_loadu_ps(&m2[8]);
+    __m128 b3 = _mm_loadu_ps(&m2[12]);
+    __m128 a0 = _mm_loadu_ps(&m1[0]);
+    __m128 a1 = _mm_loadu_ps(&m1[4]);
+    __m128 a2 = _mm_loadu_ps(&m1[8]);
+    __m128 a3 = _mm_loadu_ps(&m1[12]);
+
+    a0 = MATRIX_ROW_PRODUCT(a0, b0, b1, b2, b3);
+    a1 = MATRIX_ROW_PRODUCT(a1, b0, b1, b2, b3);
+    a2 = MATRIX_ROW_PRODUCT(a2, b0, b1, b2, b3);
+    a3 = MATRIX_ROW_PRODUCT(a3, b0, b1, b2, b3);
+
+    _mm_storeu_ps(&result[0], a0);
+    _mm_storeu_ps(&result[4], a1);
+    _mm_storeu_ps(&result[8], a2);
+    _mm_storeu_ps(&result[12], a3);
+#else
     float temp[16];
 
-    for (i = 0; i < 16; i++)
-        temp[i] = 0.0;
-    
     temp[0] = m1[0]*m2[0] + m1[1]*m2[4] + m1[2]*m2[8] + m1[3]*m2[12];
     temp[1] = m1[0]*m2[1] + m1[1]*m2[5] + m1[2]*m2[9] + m1[3]*m2[13];
     temp[2] = m1[0]*m2[2] + m1[1]*m2[6] + m1[2]*m2[10] + m1[3]*m2[14];
@@ -159,6 +376,261 @@ void MultiplyMatrix(float* m1, float* m2, float* result)
     temp[15] = m1[12]*m2[3] + m1[13]*m2[7] + m1[14]*m2[11] + m1[15]*m2[15];
 
     memcpy(result, temp, 16*sizeof(float));
+#endif
+}
+
+
+/******************************************************************
+*
+* MultiplyAffineMatrix
+*
+* Product of two matrices whose last row is (0, 0, 0, 1); that row
+* is neither read nor multiplied
+*
+*******************************************************************/
+
+void MultiplyAffineMatrix(float* m1, float* m2, float* result)
+{
+#ifdef MATRIX_SSE
+    const __m128 w_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+    __m128 b0 = _mm_loadu_ps(&m2[0]);
+    __m128 b1 = _mm_loadu_ps(&m2[4]);
+    __m128 b2 = _mm_loadu_ps(&m2[8]);
+    __m128 a0 = _mm_loadu_ps(&m1[0]);
+    __m128 a1 = _mm_loadu_ps(&m1[4]);
+    __m128 a2 = _mm_loadu_ps(&m1[8]);
+
+    a0 = MatrixAffineRow(a0, b0, b1, b2, w_mask);
+    a1 = MatrixAffineRow(a1, b0, b1, b2, w_mask);
+    a2 = MatrixAffineRow(a2, b0, b1, b2, w_mask);
+
+    _mm_storeu_ps(&result[0], a0);
+    _mm_storeu_ps(&result[4], a1);
+    _mm_storeu_ps(&result[8], a2);
+    _mm_storeu_ps(&result[12], _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+#else
+    float temp[12];
+    int i;
+
+    for (i = 0; i < 12; i += 4){
+        temp[i] = m1[i]*m2[0] + m1[i + 1]*m2[4] + m1[i + 2]*m2[8];
+        temp[i + 1] = m1[i]*m2[1] + m1[i + 1]*m2[5] + m1[i + 2]*m2[9];
+        temp[i + 2] = m1[i]*m2[2] + m1[i + 1]*m2[6] + m1[i + 2]*m2[10];
+        temp[i + 3] = m1[i]*m2[3] + m1[i + 1]*m2[7] + m1[i + 2]*m2[11] + m1[i + 3];
+    }
+
+    memcpy(result, temp, 12*sizeof(float));
+    MATRIX_AFFINE_ROW(result);
+#endif
+}
+
+
+/******************************************************************
+*
+* TransposeMatrix
+*
+*******************************************************************/
+
+void TransposeMatrix(float* m, float* result)
+{
+#ifdef MATRIX_SSE
+    __m128 r0 = _mm_loadu_ps(&m[0]);
+    __m128 r1 = _mm_loadu_ps(&m[4]);
+    __m128 r2 = _mm_loadu_ps(&m[8]);
+    __m128 r3 = _mm_loadu_ps(&m[12]);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    _mm_storeu_ps(&result[0], r0);
+    _mm_storeu_ps(&result[4], r1);
+    _mm_storeu_ps(&result[8], r2);
+    _mm_storeu_ps(&result[12], r3);
+#else
+    int i, j;
+    float temp[16];
+
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 4; j++)
+            temp[j*4 + i] = m[i*4 + j];
+
+    memcpy(result, temp, 16*sizeof(float));
+#endif
+}
+
+
+/******************************************************************
+*
+* InvertAffineMatrix
+*
+* Inverse of a matrix whose last row is (0, 0, 0, 1); the upper 3x3
+* part is inverted through the cross products of its rows. Returns 0
+* and leaves result unchanged if the matrix is singular
+*
+*******************************************************************/
+
+int InvertAffineMatrix(float* m, float* result)
+{
+#ifdef MATRIX_SSE
+    const __m128 xyz_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 r0 = _mm_loadu_ps(&m[0]);
+    __m128 r1 = _mm_loadu_ps(&m[4]);
+    __m128 r2 = _mm_loadu_ps(&m[8]);
+    __m128 c0, c1, c2, t, p, det, inv;
+
+    /* Columns of the adjugate */
+    c0 = MatrixCross(r1, r2);
+    c1 = MatrixCross(r2, r0);
+    c2 = MatrixCross(r0, r1);
+
+    p = _mm_mul_ps(r0, c0);
+    det = _mm_add_ss(_mm_add_ss(p, MATRIX_SPLAT(p, 1)), MATRIX_SPLAT(p, 2));
+    if (_mm_cvtss_f32(det) == 0.0f)
+        return 0;
+
+    inv = _mm_div_ss(_mm_set_ss(1.0f), det);
+    inv = MATRIX_SPLAT(inv, 0);
+    c0 = _mm_and_ps(_mm_mul_ps(c0, inv), xyz_mask);
+    c1 = _mm_and_ps(_mm_mul_ps(c1, inv), xyz_mask);
+    c2 = _mm_and_ps(_mm_mul_ps(c2, inv), xyz_mask);
+
+    /* Translation -A^-1 t, last row (0, 0, 0, 1) after transposing */
+    t = _mm_mul_ps(c0, MATRIX_SPLAT(r0, 3));
+    t = _mm_add_ps(t, _mm_mul_ps(c1, MATRIX_SPLAT(r1, 3)));
+    t = _mm_add_ps(t, _mm_mul_ps(c2, MATRIX_SPLAT(r2, 3)));
+    t = _mm_xor_ps(t, sign);
+    t = _mm_or_ps(_mm_and_ps(t, xyz_mask), _mm_andnot_ps(xyz_mask, _mm_set1_ps(1.0f)));
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, t);
+
+    _mm_storeu_ps(&result[0], c0);
+    _mm_storeu_ps(&result[4], c1);
+    _mm_storeu_ps(&result[8], c2);
+    _mm_storeu_ps(&result[12], t);
+#else
+    float c0[3], c1[3], c2[3];
+    float temp[16];
+    float det, inv;
+    int i;
+
+    /* Columns of the adjugate */
+    c0[0] = m[5]*m[10] - m[6]*m[9];
+    c0[1] = m[6]*m[8] - m[4]*m[10];
+    c0[2] = m[4]*m[9] - m[5]*m[8];
+
+    c1[0] = m[9]*m[2] - m[10]*m[1];
+    c1[1] = m[10]*m[0] - m[8]*m[2];
+    c1[2] = m[8]*m[1] - m[9]*m[0];
+
+    c2[0] = m[1]*m[6] - m[2]*m[5];
+    c2[1] = m[2]*m[4] - m[0]*m[6];
+    c2[2] = m[0]*m[5] - m[1]*m[4];
+
+    det = m[0]*c0[0] + m[1]*c0[1] + m[2]*c0[2];
+    if (det == 0.0f)
+        return 0;
+    inv = 1.0f / det;
+
+    for (i = 0; i < 3; i++){
+        temp[i*4] = c0[i]*inv;
+        temp[i*4 + 1] = c1[i]*inv;
+        temp[i*4 + 2] = c2[i]*inv;
+        temp[i*4 + 3] = -(temp[i*4]*m[3] + temp[i*4 + 1]*m[7] + temp[i*4 + 2]*m[11]);
+    }
+
+    temp[12] = 0.0;
+    temp[13] = 0.0;
+    temp[14] = 0.0;
+    temp[15] = 1.0;
+
+    memcpy(result, temp, 16*sizeof(float));
+#endif
+    return 1;
+}
+
+
+/******************************************************************
+*
+* TransformVector
+*
+* Product of matrix and homogeneous column vector v
+*
+*******************************************************************/
+
+void TransformVector(float* m, float* v, float* result)
+{
+#ifdef MATRIX_SSE
+    __m128 c0 = _mm_loadu_ps(&m[0]);
+    __m128 c1 = _mm_loadu_ps(&m[4]);
+    __m128 c2 = _mm_loadu_ps(&m[8]);
+    __m128 c3 = _mm_loadu_ps(&m[12]);
+    __m128 x = _mm_loadu_ps(v);
+    __m128 r;
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    r = _mm_mul_ps(c0, MATRIX_SPLAT(x, 0));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, MATRIX_SPLAT(x, 1)));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, MATRIX_SPLAT(x, 2)));
+    r = _mm_add_ps(r, _mm_mul_ps(c3, MATRIX_SPLAT(x, 3)));
+
+    _mm_storeu_ps(result, r);
+#else
+    int i;
+    float temp[4];
+
+    for (i = 0; i < 4; i++)
+        temp[i] = m[i*4]*v[0] + m[i*4 + 1]*v[1] + m[i*4 + 2]*v[2] + m[i*4 + 3]*v[3];
+
+    memcpy(result, temp, 4*sizeof(float));
+#endif
+}
+
+
+/******************************************************************
+*
+* TransformPoints
+*
+* Transform 'count' points with 3 floats each, taking w as 1; result
+* may be the same array as points
+*
+*******************************************************************/
+
+void TransformPoints(float* m, float* points, int count, float* result)
+{
+    int i;
+
+#ifdef MATRIX_SSE
+    __m128 c0 = _mm_loadu_ps(&m[0]);
+    __m128 c1 = _mm_loadu_ps(&m[4]);
+    __m128 c2 = _mm_loadu_ps(&m[8]);
+    __m128 c3 = _mm_loadu_ps(&m[12]);
+    __m128 r;
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    for (i = 0; i < count; i++){
+        r = _mm_mul_ps(c0, _mm_set1_ps(points[i*3]));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(points[i*3 + 1])));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(points[i*3 + 2])));
+        r = _mm_add_ps(r, c3);
+
+        /* Three floats only, the next point may follow directly */
+        _mm_storel_pi((__m64*)&result[i*3], r);
+        _mm_store_ss(&result[i*3 + 2], _mm_movehl_ps(r, r));
+    }
+#else
+    float x, y, z;
+
+    for (i = 0; i < count; i++){
+        x = points[i*3];
+        y = points[i*3 + 1];
+        z = points[i*3 + 2];
+        result[i*3] = m[0]*x + m[1]*y + m[2]*z + m[3];
+        result[i*3 + 1] = m[4]*x + m[5]*y + m[6]*z + m[7];
+        result[i*3 + 2] = m[8]*x + m[9]*y + m[10]*z + m[11];
+    }
+#endif
 }
 
 
@@ -187,3 +659,263 @@ void SetPerspectiveMatrix(float fov, float aspect, float nearPlane,
 }
 
 
+
+
+/******************************************************************
+*
+* SetQuaternionAxisAngle
+*
+* Rotation by angle (in degrees) about a unit length axis
+*
+*******************************************************************/
+
+void SetQuaternionAxisAngle(float* axis, float angle, Quaternion* result)
+{
+    float s, c;
+
+    MatrixSinCos(angle*0.5f, &s, &c);
+
+    result->x = axis[0]*s;
+    result->y = axis[1]*s;
+    result->z = axis[2]*s;
+    result->w = c;
+}
+
+
+/******************************************************************
+*
+* SetQuaternionEuler
+*
+* Rotation about Y * X * Z, the order of SetTransformMatrix
+*
+*******************************************************************/
+
+void SetQuaternionEuler(float anglex, float angley, float anglez, Quaternion* result)
+{
+    Quaternion qx = {0.0, 0.0, 0.0, 1.0};
+    Quaternion qy = {0.0, 0.0, 0.0, 1.0};
+    Quaternion qz = {0.0, 0.0, 0.0, 1.0};
+
+    MatrixSinCos(anglex*0.5f, &qx.x, &qx.w);
+    MatrixSinCos(angley*0.5f, &qy.y, &qy.w);
+    MatrixSinCos(anglez*0.5f, &qz.z, &qz.w);
+
+    MultiplyQuaternion(&qy, &qx, result);
+    MultiplyQuaternion(result, &qz, result);
+}
+
+
+/******************************************************************
+*
+* MultiplyQuaternion
+*
+* Rotation by q2 followed by q1; result may alias q1 or q2
+*
+*******************************************************************/
+
+void MultiplyQuaternion(Quaternion* q1, Quaternion* q2, Quaternion* result)
+{
+#ifdef MATRIX_SSE
+    __m128 a = _mm_loadu_ps(&q1->x);
+    __m128 b = _mm_loadu_ps(&q2->x);
+    __m128 r;
+
+    r = _mm_mul_ps(MATRIX_SPLAT(a, 3), b);
+    r = _mm_add_ps(r, _mm_mul_ps(MATRIX_SPLAT(a, 0),
+                   _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)), _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f))));
+    r = _mm_add_ps(r, _mm_mul_ps(MATRIX_SPLAT(a, 1),
+                   _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2)), _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f))));
+    r = _mm_add_ps(r, _mm_mul_ps(MATRIX_SPLAT(a, 2),
+                   _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)), _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f))));
+
+    _mm_storeu_ps(&result->x, r);
+#else
+    Quaternion temp;
+
+    temp.x = q1->w*q2->x + q1->x*q2->w + q1->y*q2->z - q1->z*q2->y;
+    temp.y = q1->w*q2->y - q1->x*q2->z + q1->y*q2->w + q1->z*q2->x;
+    temp.z = q1->w*q2->z + q1->x*q2->y - q1->y*q2->x + q1->z*q2->w;
+    temp.w = q1->w*q2->w - q1->x*q2->x - q1->y*q2->y - q1->z*q2->z;
+
+    *result = temp;
+#endif
+}
+
+
+/******************************************************************
+*
+* NormalizeQuaternion
+*
+*******************************************************************/
+
+void NormalizeQuaternion(Quaternion* q, Quaternion* result)
+{
+#ifdef MATRIX_SSE
+    __m128 a = _mm_loadu_ps(&q->x);
+    __m128 p = _mm_mul_ps(a, a);
+    __m128 length;
+
+    length = _mm_add_ss(_mm_add_ss(_mm_add_ss(p, MATRIX_SPLAT(p, 1)), MATRIX_SPLAT(p, 2)), MATRIX_SPLAT(p, 3));
+    length = _mm_div_ss(_mm_set_ss(1.0f), _mm_sqrt_ss(length));
+
+    _mm_storeu_ps(&result->x, _mm_mul_ps(a, MATRIX_SPLAT(length, 0)));
+#else
+    float inv = 1.0f / sqrtf(q->x*q->x + q->y*q->y + q->z*q->z + q->w*q->w);
+
+    result->x = q->x*inv;
+    result->y = q->y*inv;
+    result->z = q->z*inv;
+    result->w = q->w*inv;
+#endif
+}
+
+
+/******************************************************************
+*
+* BlendQuaternion
+*
+* a*q1 + b*q2 without normalizing
+*
+*******************************************************************/
+
+static void BlendQuaternion(Quaternion* q1, float a, Quaternion* q2, float b, Quaternion* result)
+{
+#ifdef MATRIX_SSE
+    __m128 r = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&q1->x), _mm_set1_ps(a)),
+                          _mm_mul_ps(_mm_loadu_ps(&q2->x), _mm_set1_ps(b)));
+
+    _mm_storeu_ps(&result->x, r);
+#else
+    result->x = q1->x*a + q2->x*b;
+    result->y = q1->y*a + q2->y*b;
+    result->z = q1->z*a + q2->z*b;
+    result->w = q1->w*a + q2->w*b;
+#endif
+}
+
+static inline float DotQuaternion(Quaternion* q1, Quaternion* q2)
+{
+    return q1->x*q2->x + q1->y*q2->y + q1->z*q2->z + q1->w*q2->w;
+}
+
+
+/******************************************************************
+*
+* NlerpQuaternion
+*
+* Normalized linear interpolation along the shorter arc; cheap, but
+* the angular speed is not constant
+*
+*******************************************************************/
+
+void NlerpQuaternion(Quaternion* q1, Quaternion* q2, float t, Quaternion* result)
+{
+    float b = DotQuaternion(q1, q2) < 0.0f ? -t : t;
+
+    BlendQuaternion(q1, 1.0f - t, q2, b, result);
+    NormalizeQuaternion(result, result);
+}
+
+
+/******************************************************************
+*
+* SlerpQuaternion
+*
+* Spherical linear interpolation along the shorter arc with constant
+* angular speed; nearly equal rotations use NlerpQuaternion
+*
+*******************************************************************/
+
+void SlerpQuaternion(Quaternion* q1, Quaternion* q2, float t, Quaternion* result)
+{
+    float d = DotQuaternion(q1, q2);
+    float sign = 1.0f;
+    float theta, s;
+
+    if (d < 0.0f){
+        d = -d;
+        sign = -1.0f;
+    }
+
+    if (d > 0.9995f){
+        NlerpQuaternion(q1, q2, t, result);
+        return;
+    }
+
+    theta = acosf(d);
+    s = 1.0f / sinf(theta);
+    BlendQuaternion(q1, sinf((1.0f - t)*theta)*s, q2, sign*sinf(t*theta)*s, result);
+}
+
+
+/******************************************************************
+*
+* QuaternionToMatrix
+*
+* Rotation matrix of a unit quaternion
+*
+*******************************************************************/
+
+void QuaternionToMatrix(Quaternion* q, float* result)
+{
+    float x2 = q->x + q->x, y2 = q->y + q->y, z2 = q->z + q->z;
+    float xx = q->x*x2, yy = q->y*y2, zz = q->z*z2;
+    float xy = q->x*y2, xz = q->x*z2, yz = q->y*z2;
+    float wx = q->w*x2, wy = q->w*y2, wz = q->w*z2;
+
+    result[0] = 1.0f - (yy + zz);
+    result[1] = xy - wz;
+    result[2] = xz + wy;
+    result[3] = 0.0;
+    result[4] = xy + wz;
+    result[5] = 1.0f - (xx + zz);
+    result[6] = yz - wx;
+    result[7] = 0.0;
+    result[8] = xz - wy;
+    result[9] = yz + wx;
+    result[10] = 1.0f - (xx + yy);
+    result[11] = 0.0;
+    MATRIX_AFFINE_ROW(result);
+}
+
+
+/******************************************************************
+*
+* RotateVectorQuaternion
+*
+* Rotate a vector of 3 floats by a unit quaternion, without building
+* the matrix: v + w*t + u x t with t = 2 u x v
+*
+*******************************************************************/
+
+void RotateVectorQuaternion(Quaternion* q, float* v, float* result)
+{
+#ifdef MATRIX_SSE
+    __m128 u = _mm_loadu_ps(&q->x);
+    __m128 x = _mm_set_ps(0.0f, v[2], v[1], v[0]);
+    __m128 t, r;
+
+    t = MatrixCross(u, x);
+    t = _mm_add_ps(t, t);
+    r = _mm_add_ps(_mm_add_ps(x, _mm_mul_ps(MATRIX_SPLAT(u, 3), t)), MatrixCross(u, t));
+
+    _mm_storel_pi((__m64*)result, r);
+    _mm_store_ss(&result[2], _mm_movehl_ps(r, r));
+#else
+    float t[3];
+    float temp[3];
+
+    t[0] = q->y*v[2] - q->z*v[1];
+    t[1] = q->z*v[0] - q->x*v[2];
+    t[2] = q->x*v[1] - q->y*v[0];
+    t[0] += t[0];
+    t[1] += t[1];
+    t[2] += t[2];
+
+    temp[0] = v[0] + q->w*t[0] + (q->y*t[2] - q->z*t[1]);
+    temp[1] = v[1] + q->w*t[1] + (q->z*t[0] - q->x*t[2]);
+    temp[2] = v[2] + q->w*t[2] + (q->x*t[1] - q->y*t[0]);
+
+    memcpy(result, temp, 3*sizeof(float));
+#endif
+}
@@ -1,28 +1,66 @@
-/******************************************************************
-*
-* Matrix.h
-*
-* Description: Helper routine for matrix computations.
-* 	
-*
-* Computer Graphics Proseminar SS 2015
-* 
-* Interactive Graphics and Simulation Group
-* Institute of Computer Science
-* University of Innsbruck
-*
-*******************************************************************/
-
-
-#ifndef __MATRIX_H__
-#define __MATRIX_H__
-
-void SetIdentityMatrix(float* result);
-void SetRotationX(float anglex, float* result);
-void SetRotationY(float angley, float* result);
-void SetRotationZ(float anglez, float* result);
-void SetTranslation(float x, float y, float z, float* result);
-void MultiplyMatrix(float* m1, float* m2, float* result);
-void SetPerspectiveMatrix(float fov, float aspect, float nearPlane, float farPlane, float* result);
-
-#endif // __MATRIX_H__
+/******************************************************************
+*
+* Matrix.h
+*
+* Description: Helper routine for matrix computations.
+* 	
+*              Matrices are 4x4, row-major, and vectors are column
+*              vectors, i.e. the translation is in elements 3, 7, 11.
+*              On x86 the products use SSE (and AVX if the CPU has
+*              it) with results identical to the scalar code; build
+*              with -DMATRIX_NO_SIMD for the scalar code only or with
+*              -DMATRIX_NO_AVX for SSE only. 'make matrix-bench'
+*              checks that all paths agree.
+*
+*              Rotations may also be kept as unit quaternions, which
+*              are composed and interpolated without matrices and
+*              converted once when the matrix is needed.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+
+#ifndef __MATRIX_H__
+#define __MATRIX_H__
+
+/* Rotation as unit quaternion; the layout matches one SSE register */
+typedef struct
+{
+    float x, y, z;          /* Axis times sine of half the angle */
+    float w;                /* Cosine of half the angle */
+} Quaternion;
+
+void SetIdentityMatrix(float* result);
+void SetRotationX(float anglex, float* result);
+void SetRotationY(float angley, float* result);
+void SetRotationZ(float anglez, float* result);
+void SetTranslation(float x, float y, float z, float* result);
+void SetTransformMatrix(float x, float y, float z,
+                        float anglex, float angley, float anglez,
+                        float scalex, float scaley, float scalez, float* result);
+void TranslateMatrix(float* m, float x, float y, float z);
+void RotateMatrixX(float* m, float anglex);
+void RotateMatrixY(float* m, float angley);
+void RotateMatrixZ(float* m, float anglez);
+void MultiplyMatrix(float* m1, float* m2, float* result);
+void MultiplyAffineMatrix(float* m1, float* m2, float* result);
+void TransposeMatrix(float* m, float* result);
+int InvertAffineMatrix(float* m, float* result);
+void TransformVector(float* m, float* v, float* result);
+void TransformPoints(float* m, float* points, int count, float* result);
+void SetQuaternionAxisAngle(float* axis, float angle, Quaternion* result);
+void SetQuaternionEuler(float anglex, float angley, float anglez, Quaternion* result);
+void MultiplyQuaternion(Quaternion* q1, Quaternion* q2, Quaternion* result);
+void NormalizeQuaternion(Quaternion* q, Quaternion* result);
+void NlerpQuaternion(Quaternion* q1, Quaternion* q2, float t, Quaternion* result);
+void SlerpQuaternion(Quaternion* q1, Quaternion* q2, float t, Quaternion* result);
+void QuaternionToMatrix(Quaternion* q, float* result);
+void RotateVectorQuaternion(Quaternion* q, float* v, float* result);
+void SetPerspectiveMatrix(float fov, float aspect, float nearPlane, float farPlane, float* result);
+
+#endif // __MATRIX_H__
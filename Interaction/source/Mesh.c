@@ -0,0 +1,408 @@
+/******************************************************************
+*
+* Mesh.c
+*
+* Description: Flat triangle mesh ready for upload to buffer
+*              objects: one interleaved vertex array and one index
+*              array, either allocated separately or pointing into
+*              one block holding a mesh cache file.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/* POSIX includes */
+#include <sys/mman.h>
+
+#include "Mesh.h"
+
+#define MESH_SLOT_EMPTY -1
+
+/* Open-addressing table mapping (position, texture, normal) index
+ * tuples of face corners to unified vertices */
+typedef struct
+{
+	int *slots;                 //unified vertex or MESH_SLOT_EMPTY
+	int *keys;                  //3 indices per unified vertex
+	unsigned int mask;
+	int count;
+} mesh_vertex_table;
+
+
+// internal helper functions
+double mesh_seconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+int mesh_vertex_table_make(mesh_vertex_table *table, int corner_count)
+{
+	unsigned int size = 16;
+	unsigned int i;
+
+	//at most half full, so probe sequences stay short
+	while(size < (unsigned int)corner_count*2)
+		size *= 2;
+
+	table->slots = (int*) malloc(sizeof(int) * size);
+	table->keys = (int*) malloc(sizeof(int) * 3 * corner_count + 1);
+	table->mask = size - 1;
+	table->count = 0;
+
+	if(table->slots == NULL || table->keys == NULL)
+	{
+		free(table->slots);
+		free(table->keys);
+		return 0;
+	}
+
+	for(i=0; i<size; i++)
+		table->slots[i] = MESH_SLOT_EMPTY;
+
+	return 1;
+}
+
+int mesh_vertex_table_insert(mesh_vertex_table *table, int position, int texture, int normal)
+{
+	unsigned int hash;
+	int *key;
+
+	hash = (unsigned int)position*0x9e3779b1u ^ (unsigned int)texture*0x85ebca77u ^ (unsigned int)normal*0xc2b2ae3du;
+	hash ^= hash >> 16;
+
+	for(hash &= table->mask; table->slots[hash] != MESH_SLOT_EMPTY; hash = (hash + 1) & table->mask)
+	{
+		key = table->keys + table->slots[hash]*3;
+		if(key[0] == position && key[1] == texture && key[2] == normal)
+			return table->slots[hash];
+	}
+
+	key = table->keys + table->count*3;
+	key[0] = position;
+	key[1] = texture;
+	key[2] = normal;
+	table->slots[hash] = table->count;
+
+	return table->count++;
+}
+
+void mesh_vertex_table_free(mesh_vertex_table *table)
+{
+	free(table->slots);
+	free(table->keys);
+}
+
+void mesh_narrow_indices(void *indices, int count, int index_size)
+{
+	const unsigned int *wide = (const unsigned int*) indices;
+	unsigned short *index16 = (unsigned short*) indices;
+	unsigned char *index8 = (unsigned char*) indices;
+	int i;
+
+	//narrowed in place, every store lands at or before the next load
+	if(index_size == 2)
+		for(i=0; i<count; i++)
+			index16[i] = (unsigned short)wide[i];
+	else if(index_size == 1)
+		for(i=0; i<count; i++)
+			index8[i] = (unsigned char)wide[i];
+}
+
+void mesh_copy_reals(float *dst, const obj_real *src, int index, int count, int size)
+{
+	int i;
+
+	//attributes without a valid index are zero
+	for(i=0; i<size; i++)
+		dst[i] = index >= 0 && index < count ? (float)src[index*3+i] : 0.0f;
+}
+
+uint64_t mesh_hash_word(uint64_t hash, uint64_t word)
+{
+	word *= 0xff51afd7ed558ccdull;
+	word ^= word >> 32;
+	return (hash ^ word) * 0xc4ceb9fe1a85ec53ull;
+}
+
+/* Mixes size bytes into hash, eight at a time */
+uint64_t mesh_hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = (const unsigned char*) data;
+	uint64_t word;
+
+	for(; size >= sizeof(word); bytes += sizeof(word), size -= sizeof(word))
+	{
+		memcpy(&word, bytes, sizeof(word));
+		hash = mesh_hash_word(hash, word);
+	}
+
+	if(size > 0)
+	{
+		word = 0;
+		memcpy(&word, bytes, size);
+		hash = mesh_hash_word(hash, word);
+	}
+
+	return hash ^ (hash >> 29);
+}
+//end helpers
+
+
+int mesh_vertex_size(int format)
+{
+	return 3 + (format & MESH_NORMAL ? 3 : 0) + (format & MESH_TEXTURE ? 2 : 0);
+}
+
+int mesh_index_size(int vertex_count)
+{
+	if(vertex_count <= 256)
+		return 1;
+	if(vertex_count <= 65536)
+		return 2;
+	return 4;
+}
+
+int mesh_texture_offset(int format)
+{
+	return format & MESH_NORMAL ? 6 : 3;
+}
+
+/* Hash of the layout, vertices and indices; equal meshes have equal
+ * hashes, unequal ones almost never */
+uint64_t mesh_hash(const mesh *mesh_o)
+{
+	int layout[4] = {mesh_o->format, mesh_o->vertex_count, mesh_o->index_count, mesh_o->index_size};
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	hash = mesh_hash_bytes(hash, layout, sizeof(layout));
+	hash = mesh_hash_bytes(hash, mesh_o->vertices, sizeof(float) * mesh_o->vertex_size * mesh_o->vertex_count);
+	hash = mesh_hash_bytes(hash, mesh_o->indices, (size_t)mesh_o->index_size * mesh_o->index_count);
+	return hash;
+}
+
+/* Same layout and bitwise the same contents */
+int mesh_equal(const mesh *a, const mesh *b)
+{
+	if(a->format != b->format || a->vertex_count != b->vertex_count ||
+	   a->index_count != b->index_count || a->index_size != b->index_size ||
+	   a->lod_count != b->lod_count || memcmp(a->lods, b->lods, sizeof(mesh_lod) * a->lod_count) != 0)
+		return 0;
+
+	return memcmp(a->vertices, b->vertices, sizeof(float) * a->vertex_size * a->vertex_count) == 0 &&
+	       memcmp(a->indices, b->indices, (size_t)a->index_size * a->index_count) == 0;
+}
+
+/* Box of the positions and the sphere around its middle; both empty
+ * at the origin without vertices */
+void mesh_compute_bounds(mesh *mesh_o)
+{
+	mesh_bounds *bounds = &mesh_o->bounds;
+	const float *vertex;
+	float distance, dx, dy, dz;
+	int i, j;
+
+	memset(bounds, 0, sizeof(mesh_bounds));
+	if(mesh_o->vertex_count == 0)
+		return;
+
+	memcpy(bounds->min, mesh_o->vertices, sizeof(float) * 3);
+	memcpy(bounds->max, mesh_o->vertices, sizeof(float) * 3);
+	for(i=1; i<mesh_o->vertex_count; i++)
+	{
+		vertex = mesh_o->vertices + i * mesh_o->vertex_size;
+		for(j=0; j<3; j++)
+		{
+			if(vertex[j] < bounds->min[j])
+				bounds->min[j] = vertex[j];
+			if(vertex[j] > bounds->max[j])
+				bounds->max[j] = vertex[j];
+		}
+	}
+
+	for(j=0; j<3; j++)
+		bounds->center[j] = 0.5f * (bounds->min[j] + bounds->max[j]);
+
+	//the half diagonal of the box would do, but the farthest position
+	//is closer for round meshes
+	for(i=0; i<mesh_o->vertex_count; i++)
+	{
+		vertex = mesh_o->vertices + i * mesh_o->vertex_size;
+		dx = vertex[0] - bounds->center[0];
+		dy = vertex[1] - bounds->center[1];
+		dz = vertex[2] - bounds->center[2];
+		distance = dx*dx + dy*dy + dz*dz;
+		if(distance > bounds->radius)
+			bounds->radius = distance;
+	}
+	bounds->radius = sqrtf(bounds->radius);
+}
+
+int mesh_from_flat(mesh *mesh_o, const obj_flat_scene_data *data, mesh_build_report *report)
+{
+	mesh_vertex_table table;
+	double start = mesh_seconds();
+	int corner_count = 0;
+	int triangle_count = 0;
+	int i, j, corners, corner, normal, texture;
+	int unified, first = 0, previous = 0;
+	unsigned int *triangle;
+	void *narrowed;
+	const int *key;
+	float *vertex;
+
+	memset(mesh_o, 0, sizeof(mesh));
+
+	//faces with more than three corners are split into fans, however
+	//many corners they have
+	for(i=0; i<data->face_count; i++)
+	{
+		corners = data->face_start[i+1] - data->face_start[i];
+		if(corners >= 3)
+		{
+			corner_count += corners;
+			triangle_count += corners - 2;
+		}
+	}
+
+	mesh_o->format = (data->vertex_normal_count > 0 ? MESH_NORMAL : 0) |
+	                 (data->vertex_texture_count > 0 ? MESH_TEXTURE : 0);
+	mesh_o->vertex_size = mesh_vertex_size(mesh_o->format);
+	mesh_o->index_count = triangle_count*3;
+	mesh_o->indices = malloc(sizeof(unsigned int) * mesh_o->index_count + 1);
+
+	if(mesh_o->indices == NULL || !mesh_vertex_table_make(&table, corner_count))
+	{
+		mesh_free(mesh_o);
+		return 0;
+	}
+
+	//built with 32 bit indices, narrowed once the vertex count is known
+	triangle = (unsigned int*) mesh_o->indices;
+	for(i=0; i<data->face_count; i++)
+	{
+		corners = data->face_start[i+1] - data->face_start[i];
+		if(corners < 3)
+			continue;
+
+		for(j=0; j<corners; j++)
+		{
+			corner = data->face_start[i] + j;
+
+			if(data->face_vertex_index[corner] < 0 || data->face_vertex_index[corner] >= data->vertex_count)
+				break;
+
+			//attributes missing from the format do not split vertices
+			texture = mesh_o->format & MESH_TEXTURE ? data->face_texture_index[corner] : -1;
+			normal = mesh_o->format & MESH_NORMAL ? data->face_normal_index[corner] : -1;
+			unified = mesh_vertex_table_insert(&table, data->face_vertex_index[corner], texture, normal);
+
+			//fan around the first corner
+			if(j >= 2)
+			{
+				triangle[0] = first;
+				triangle[1] = previous;
+				triangle[2] = unified;
+				triangle += 3;
+			}
+			if(j == 0)
+				first = unified;
+			previous = unified;
+		}
+
+		if(j < corners)
+		{
+			mesh_vertex_table_free(&table);
+			mesh_free(mesh_o);
+			return 0;
+		}
+	}
+
+	mesh_o->vertex_count = table.count;
+	mesh_o->index_size = mesh_index_size(table.count);
+	mesh_narrow_indices(mesh_o->indices, mesh_o->index_count, mesh_o->index_size);
+	narrowed = realloc(mesh_o->indices, (size_t)mesh_o->index_size * mesh_o->index_count + 1);
+	if(narrowed != NULL)
+		mesh_o->indices = narrowed;
+
+	mesh_o->vertices = (float*) malloc(sizeof(float) * mesh_o->vertex_size * mesh_o->vertex_count + 1);
+	if(mesh_o->vertices == NULL)
+	{
+		mesh_vertex_table_free(&table);
+		mesh_free(mesh_o);
+		return 0;
+	}
+
+	for(i=0; i<table.count; i++)
+	{
+		key = table.keys + i*3;
+		vertex = mesh_o->vertices + i*mesh_o->vertex_size;
+
+		mesh_copy_reals(vertex, data->vertices, key[0], data->vertex_count, 3);
+		if(mesh_o->format & MESH_NORMAL)
+			mesh_copy_reals(vertex + MESH_NORMAL_OFFSET, data->vertex_normals, key[2], data->vertex_normal_count, 3);
+		if(mesh_o->format & MESH_TEXTURE)
+			mesh_copy_reals(vertex + mesh_texture_offset(mesh_o->format), data->vertex_textures, key[1], data->vertex_texture_count, 2);
+	}
+
+	mesh_vertex_table_free(&table);
+	mesh_compute_bounds(mesh_o);
+
+	if(report != NULL)
+	{
+		report->position_count = data->vertex_count;
+		report->normal_count = data->vertex_normal_count;
+		report->texture_count = data->vertex_texture_count;
+		report->corner_count = corner_count;
+		report->vertex_count = mesh_o->vertex_count;
+		report->triangle_count = triangle_count;
+		report->build_seconds = mesh_seconds() - start;
+	}
+
+	return 1;
+}
+
+int mesh_load_obj(mesh *mesh_o, char *filename, mesh_build_report *report)
+{
+	obj_flat_scene_data data;
+	int success;
+
+	memset(mesh_o, 0, sizeof(mesh));
+
+	if(!parse_obj_scene_flat(&data, filename))
+		return 0;
+
+	success = mesh_from_flat(mesh_o, &data, report);
+	delete_obj_flat_data(&data);
+
+	return success;
+}
+
+void mesh_free(mesh *mesh_o)
+{
+	if(mesh_o->storage != NULL)
+	{
+		if(mesh_o->mapped)
+			munmap(mesh_o->storage, mesh_o->storage_size);
+		else
+			free(mesh_o->storage);
+	}
+	else
+	{
+		free(mesh_o->vertices);
+		free(mesh_o->indices);
+	}
+
+	memset(mesh_o, 0, sizeof(mesh));
+}
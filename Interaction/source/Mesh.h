@@ -0,0 +1,106 @@
+/******************************************************************
+*
+* Mesh.h
+*
+* Description: Flat triangle mesh ready for upload to buffer
+*              objects: one interleaved vertex array and one index
+*              array, either allocated separately or pointing into
+*              one block holding a mesh cache file.
+*
+*              OBJ faces index positions, texture coordinates and
+*              normals separately; every distinct combination used
+*              by a face corner becomes one vertex of the mesh.
+*
+*              Every mesh carries an axis aligned box and a sphere
+*              around its positions, kept up to date by the steps
+*              that change them.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __MESH_H
+#define __MESH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "OBJParser.h"
+
+/* Optional vertex attributes following the position */
+#define MESH_NORMAL  0x1            //3 floats
+#define MESH_TEXTURE 0x2            //2 floats, after the normal if present
+#define MESH_NORMAL_OFFSET 3        //floats before the normal
+
+/* Bounds of the positions of a mesh */
+typedef struct
+{
+	float min[3];
+	float max[3];
+	float center[3];            //of the sphere; the middle of the box
+	float radius;               //distance of the farthest position
+} mesh_bounds;
+
+/* Most levels of detail a mesh holds */
+#define MESH_MAX_LODS 8
+
+/* One level of detail: a range of the index array */
+typedef struct
+{
+	int first_index;
+	int index_count;
+	float error;                //largest deviation from the full mesh, model units
+} mesh_lod;
+
+typedef struct
+{
+	float *vertices;            //vertex_size floats per vertex
+	void *indices;              //3 per triangle, index_size bytes each
+
+	int vertex_count;
+	int vertex_size;
+	int format;                 //combination of MESH_NORMAL and MESH_TEXTURE
+	int index_count;
+	int index_size;             //1, 2 or 4, the smallest fitting vertex_count
+
+	//levels of detail, finest first, all using the same vertices;
+	//without any the whole index array is the only level
+	int lod_count;
+	mesh_lod lods[MESH_MAX_LODS];
+
+	mesh_bounds bounds;
+
+	void *storage;              //single block the arrays point into, if any
+	size_t storage_size;
+	char mapped;                //storage is a mapping of a cache file
+} mesh;
+
+/* Sizes and timing of one mesh build */
+typedef struct
+{
+	int position_count;
+	int normal_count;
+	int texture_count;
+	int corner_count;           //face corners referenced by triangles
+	int vertex_count;           //unified vertices
+	int triangle_count;
+	double build_seconds;       //without parsing
+} mesh_build_report;
+
+int mesh_vertex_size(int format);
+int mesh_index_size(int vertex_count);
+int mesh_texture_offset(int format);
+
+uint64_t mesh_hash(const mesh *mesh_o);
+int mesh_equal(const mesh *a, const mesh *b);
+void mesh_compute_bounds(mesh *mesh_o);
+
+int mesh_from_flat(mesh *mesh_o, const obj_flat_scene_data *data, mesh_build_report *report);
+int mesh_load_obj(mesh *mesh_o, char *filename, mesh_build_report *report);
+void mesh_free(mesh *mesh_o);
+
+#endif
@@ -0,0 +1,255 @@
+/******************************************************************
+*
+* MeshCache.c
+*
+* Description: Binary cache of cooked meshes. A cache file holds a
+*              header, with the level of detail ranges and bounds,
+*              followed by the interleaved vertex array and the index
+*              array, each aligned so that the file can be mapped and
+*              used in place. A cache is fresh while the path, size
+*              and modification time of its source OBJ file are
+*              unchanged.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* POSIX includes */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MeshCache.h"
+
+#define MESH_CACHE_ALIGN(x) (((x) + MESH_CACHE_ALIGNMENT - 1) & ~(uint64_t)(MESH_CACHE_ALIGNMENT - 1))
+
+
+// internal helper functions
+uint64_t mesh_cache_vertices_size(const mesh_cache_header *header)
+{
+	return sizeof(float) * mesh_vertex_size(header->vertex_format) * (uint64_t)header->vertex_count;
+}
+
+void mesh_cache_make_header(mesh_cache_header *header, const char *source_filename,
+                            const struct stat *info, const mesh *mesh_o)
+{
+	memset(header, 0, sizeof(mesh_cache_header));
+
+	header->magic = MESH_CACHE_MAGIC;
+	header->version = MESH_CACHE_VERSION;
+
+	strncpy(header->source_path, source_filename, MESH_CACHE_PATH_SIZE - 1);
+	header->source_size = info->st_size;
+	header->source_mtime_sec = info->st_mtim.tv_sec;
+	header->source_mtime_nsec = info->st_mtim.tv_nsec;
+
+	header->vertex_count = mesh_o->vertex_count;
+	header->vertex_format = mesh_o->format;
+	header->index_count = mesh_o->index_count;
+	header->index_size = mesh_o->index_size;
+	header->lod_count = mesh_o->lod_count;
+	memcpy(header->lods, mesh_o->lods, sizeof(mesh_lod) * mesh_o->lod_count);
+	header->bounds = mesh_o->bounds;
+
+	header->vertices_offset = MESH_CACHE_ALIGN(sizeof(mesh_cache_header));
+	header->indices_offset = MESH_CACHE_ALIGN(header->vertices_offset + mesh_cache_vertices_size(header));
+	header->file_size = header->indices_offset + (uint64_t)header->index_size * header->index_count;
+}
+
+int mesh_cache_is_fresh(const mesh_cache_header *header, size_t file_size,
+                        const char *source_filename, const struct stat *info)
+{
+	uint32_t i;
+
+	if(file_size < sizeof(mesh_cache_header))
+		return 0;
+
+	if(header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION ||
+	   header->index_size != (uint32_t)mesh_index_size(header->vertex_count) || header->file_size > file_size ||
+	   (header->vertex_format & ~(MESH_NORMAL | MESH_TEXTURE)) != 0 || header->lod_count > MESH_MAX_LODS)
+		return 0;
+
+	for(i=0; i<header->lod_count; i++)
+		if(header->lods[i].first_index < 0 || header->lods[i].index_count < 0 ||
+		   (uint64_t)header->lods[i].first_index + header->lods[i].index_count > header->index_count)
+			return 0;
+
+	if(strncmp(header->source_path, source_filename, MESH_CACHE_PATH_SIZE) != 0 ||
+	   header->source_size != info->st_size ||
+	   header->source_mtime_sec != info->st_mtim.tv_sec ||
+	   header->source_mtime_nsec != info->st_mtim.tv_nsec)
+		return 0;
+
+	return(header->vertices_offset + mesh_cache_vertices_size(header) <= header->indices_offset &&
+	       header->indices_offset + (uint64_t)header->index_size * header->index_count <= header->file_size);
+}
+
+void mesh_cache_assign(mesh *mesh_o, char *base, size_t size)
+{
+	const mesh_cache_header *header = (const mesh_cache_header*) base;
+
+	mesh_o->vertices = (float*)(base + header->vertices_offset);
+	mesh_o->indices = base + header->indices_offset;
+	mesh_o->vertex_count = header->vertex_count;
+	mesh_o->format = header->vertex_format;
+	mesh_o->vertex_size = mesh_vertex_size(header->vertex_format);
+	mesh_o->index_count = header->index_count;
+	mesh_o->index_size = header->index_size;
+	mesh_o->lod_count = header->lod_count;
+	memcpy(mesh_o->lods, header->lods, sizeof(mesh_lod) * header->lod_count);
+	mesh_o->bounds = header->bounds;
+	mesh_o->storage = base;
+	mesh_o->storage_size = size;
+}
+
+int mesh_cache_write_padded(FILE *file, const void *data, uint64_t size, uint64_t end)
+{
+	static const char zeros[MESH_CACHE_ALIGNMENT];
+	uint64_t padding = end - (ftell(file) + size);
+
+	if(size != 0 && fwrite(data, 1, size, file) != size)
+		return 0;
+
+	//offsets are aligned one after the other, padding is always short
+	return(padding == 0 || fwrite(zeros, 1, padding, file) == padding);
+}
+//end helpers
+
+void mesh_cache_filename(const char *source_filename, char *cache_filename, int size)
+{
+	int length = strlen(source_filename);
+
+	if(length >= 4 && strcmp(source_filename + length - 4, ".obj") == 0)
+		length -= 4;
+
+	snprintf(cache_filename, size, "%.*s%s", length, source_filename, MESH_CACHE_EXTENSION);
+}
+
+int mesh_cache_write(const char *source_filename, const mesh *mesh_o)
+{
+	char cache_filename[MESH_CACHE_PATH_SIZE];
+	char temp_filename[MESH_CACHE_PATH_SIZE + 32];
+	mesh_cache_header header;
+	struct stat info;
+	FILE *file;
+	int success;
+
+	if(stat(source_filename, &info) != 0)
+		return 0;
+
+	mesh_cache_make_header(&header, source_filename, &info, mesh_o);
+	mesh_cache_filename(source_filename, cache_filename, MESH_CACHE_PATH_SIZE);
+
+	//write next to the target and rename, so readers never see a partial file
+	snprintf(temp_filename, sizeof(temp_filename), "%s.%ld.tmp", cache_filename, (long)getpid());
+	file = fopen(temp_filename, "wb");
+	if(file == NULL)
+		return 0;
+
+	success = mesh_cache_write_padded(file, &header, sizeof(header), header.vertices_offset) &&
+	          mesh_cache_write_padded(file, mesh_o->vertices, mesh_cache_vertices_size(&header), header.indices_offset) &&
+	          mesh_cache_write_padded(file, mesh_o->indices, (uint64_t)header.index_size * header.index_count, header.file_size);
+
+	if(fclose(file) != 0)
+		success = 0;
+
+	if(!success || rename(temp_filename, cache_filename) != 0)
+	{
+		remove(temp_filename);
+		return 0;
+	}
+
+	return 1;
+}
+
+int mesh_cache_map(const char *source_filename, mesh *mesh_o)
+{
+	char cache_filename[MESH_CACHE_PATH_SIZE];
+	struct stat source_info;
+	struct stat cache_info;
+	void *mapping;
+	int fd;
+
+	if(stat(source_filename, &source_info) != 0)
+		return 0;
+
+	mesh_cache_filename(source_filename, cache_filename, MESH_CACHE_PATH_SIZE);
+	fd = open(cache_filename, O_RDONLY);
+	if(fd < 0)
+		return 0;
+
+	if(fstat(fd, &cache_info) != 0 || (size_t)cache_info.st_size < sizeof(mesh_cache_header))
+	{
+		close(fd);
+		return 0;
+	}
+
+	mapping = mmap(NULL, cache_info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED)
+		return 0;
+
+	if(!mesh_cache_is_fresh((const mesh_cache_header*)mapping, cache_info.st_size, source_filename, &source_info))
+	{
+		munmap(mapping, cache_info.st_size);
+		return 0;
+	}
+
+	memset(mesh_o, 0, sizeof(mesh));
+	mesh_cache_assign(mesh_o, (char*)mapping, cache_info.st_size);
+	mesh_o->mapped = 1;
+	return 1;
+}
+
+int mesh_cache_read(const char *source_filename, mesh *mesh_o)
+{
+	char cache_filename[MESH_CACHE_PATH_SIZE];
+	struct stat source_info;
+	struct stat cache_info;
+	char *buffer;
+	size_t size = 0;
+	ssize_t count;
+	int fd;
+
+	if(stat(source_filename, &source_info) != 0)
+		return 0;
+
+	mesh_cache_filename(source_filename, cache_filename, MESH_CACHE_PATH_SIZE);
+	fd = open(cache_filename, O_RDONLY);
+	if(fd < 0)
+		return 0;
+
+	if(fstat(fd, &cache_info) != 0 || (size_t)cache_info.st_size < sizeof(mesh_cache_header) ||
+	   (buffer = (char*) malloc(cache_info.st_size)) == NULL)
+	{
+		close(fd);
+		return 0;
+	}
+
+	while(size < (size_t)cache_info.st_size &&
+	      (count = read(fd, buffer + size, cache_info.st_size - size)) > 0)
+		size += count;
+	close(fd);
+
+	if(size != (size_t)cache_info.st_size ||
+	   !mesh_cache_is_fresh((const mesh_cache_header*)buffer, size, source_filename, &source_info))
+	{
+		free(buffer);
+		return 0;
+	}
+
+	memset(mesh_o, 0, sizeof(mesh));
+	mesh_cache_assign(mesh_o, buffer, size);
+	mesh_o->mapped = 0;
+	return 1;
+}
@@ -0,0 +1,62 @@
+/******************************************************************
+*
+* MeshCache.h
+*
+* Description: Binary cache of cooked meshes. A cache file holds a
+*              header, with the level of detail ranges and bounds,
+*              followed by the interleaved vertex array and the index
+*              array, each aligned so that the file can be mapped and
+*              used in place. A cache is fresh while the path, size
+*              and modification time of its source OBJ file are
+*              unchanged.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __MESH_CACHE_H
+#define __MESH_CACHE_H
+
+#include <stdint.h>
+
+#include "Mesh.h"
+
+#define MESH_CACHE_MAGIC 0x4853454d  //"MESH"
+#define MESH_CACHE_VERSION 6
+#define MESH_CACHE_ALIGNMENT 64
+#define MESH_CACHE_EXTENSION ".mesh"
+#define MESH_CACHE_PATH_SIZE 256
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+
+	char source_path[MESH_CACHE_PATH_SIZE];
+	int64_t source_size;
+	int64_t source_mtime_sec;
+	int64_t source_mtime_nsec;
+
+	uint32_t vertex_count;
+	uint32_t vertex_format;
+	uint32_t index_count;
+	uint32_t index_size;
+	uint32_t lod_count;
+	mesh_lod lods[MESH_MAX_LODS];
+	mesh_bounds bounds;
+
+	uint64_t vertices_offset;
+	uint64_t indices_offset;
+	uint64_t file_size;
+} mesh_cache_header;
+
+void mesh_cache_filename(const char *source_filename, char *cache_filename, int size);
+int mesh_cache_write(const char *source_filename, const mesh *mesh_o);
+int mesh_cache_map(const char *source_filename, mesh *mesh_o);
+int mesh_cache_read(const char *source_filename, mesh *mesh_o);
+
+#endif
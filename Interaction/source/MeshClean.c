@@ -0,0 +1,310 @@
+/******************************************************************
+*
+* MeshClean.c
+*
+* Description: Welding of nearly equal vertices, removal of
+*              degenerate and duplicate triangles and compaction of
+*              unused vertices.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "MeshClean.h"
+
+#define MESH_CLEAN_NONE -1
+
+
+// internal helper functions
+double mesh_clean_seconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+size_t mesh_clean_bytes(const mesh *mesh_o)
+{
+	return sizeof(float) * mesh_o->vertex_size * mesh_o->vertex_count +
+	       (size_t)mesh_o->index_size * mesh_o->index_count;
+}
+
+/* Smallest power of two at least twice count, so tables stay half empty */
+unsigned int mesh_clean_table_size(int count)
+{
+	unsigned int size = 16;
+
+	while(size < (unsigned int)count*2)
+		size *= 2;
+	return size;
+}
+
+unsigned int mesh_clean_hash(unsigned int a, unsigned int b, unsigned int c)
+{
+	unsigned int hash = a*0x9e3779b1u ^ b*0x85ebca77u ^ c*0xc2b2ae3du;
+	return hash ^ (hash >> 16);
+}
+
+/* Grid cell of a coordinate, for cells of size epsilon */
+long long mesh_clean_cell(float coordinate, float epsilon)
+{
+	return (long long)floor((double)coordinate / epsilon);
+}
+
+int mesh_clean_same_vertex(const float *a, const float *b, int size, float epsilon)
+{
+	float dx = a[0] - b[0];
+	float dy = a[1] - b[1];
+	float dz = a[2] - b[2];
+	int i;
+
+	if(dx*dx + dy*dy + dz*dz > epsilon*epsilon)
+		return 0;
+
+	for(i=3; i<size; i++)
+		if(fabsf(a[i] - b[i]) > epsilon)
+			return 0;
+
+	return 1;
+}
+
+/* Height over the longest edge below epsilon, or no edges at all */
+int mesh_clean_is_thin(const float *a, const float *b, const float *c, float epsilon)
+{
+	float ab[3], ac[3], bc[3], normal[3];
+	float longest, length;
+	int i;
+
+	for(i=0; i<3; i++)
+	{
+		ab[i] = b[i] - a[i];
+		ac[i] = c[i] - a[i];
+		bc[i] = c[i] - b[i];
+	}
+
+	normal[0] = ab[1]*ac[2] - ab[2]*ac[1];
+	normal[1] = ab[2]*ac[0] - ab[0]*ac[2];
+	normal[2] = ab[0]*ac[1] - ab[1]*ac[0];
+
+	longest = ab[0]*ab[0] + ab[1]*ab[1] + ab[2]*ab[2];
+	length = ac[0]*ac[0] + ac[1]*ac[1] + ac[2]*ac[2];
+	if(length > longest)
+		longest = length;
+	length = bc[0]*bc[0] + bc[1]*bc[1] + bc[2]*bc[2];
+	if(length > longest)
+		longest = length;
+
+	//|normal| is twice the area, and twice the area over the longest
+	//edge is twice the height
+	return normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2] <= epsilon*epsilon*longest;
+}
+
+/* Corners rotated so the smallest comes first; keeps the winding */
+void mesh_clean_rotate(const unsigned int *triangle, unsigned int *key)
+{
+	int first = 0;
+
+	if(triangle[1] < triangle[first])
+		first = 1;
+	if(triangle[2] < triangle[first])
+		first = 2;
+
+	key[0] = triangle[first];
+	key[1] = triangle[(first + 1) % 3];
+	key[2] = triangle[(first + 2) % 3];
+}
+//end helpers
+
+
+/* Clean a mesh in place; epsilon must be positive. The arrays are
+ * shrunk unless they point into a shared block */
+int mesh_clean(mesh *mesh_o, float epsilon, mesh_clean_report *report)
+{
+	double start = mesh_clean_seconds();
+	size_t bytes_before = mesh_clean_bytes(mesh_o);
+	int size = mesh_o->vertex_size;
+	int triangle_count = mesh_o->index_count / 3;
+	unsigned int vertex_mask = mesh_clean_table_size(mesh_o->vertex_count) - 1;
+	unsigned int triangle_mask = mesh_clean_table_size(triangle_count) - 1;
+	unsigned int *indices, *triangle, key[3], other[3];
+	int *remap, *next, *cells, *triangles;
+	int welded = 0, degenerate = 0, duplicate = 0;
+	int kept = 0, count = 0;
+	long long x, y, z;
+	unsigned int hash;
+	const float *vertex;
+	void *shrunk;
+	int dx, dy, dz;
+	int i, v, w;
+
+	if(epsilon <= 0.0f)
+		return 0;
+
+	indices = (unsigned int*) malloc(sizeof(unsigned int) * mesh_o->index_count + 1);
+	remap = (int*) malloc(sizeof(int) * mesh_o->vertex_count + 1);
+	next = (int*) malloc(sizeof(int) * mesh_o->vertex_count + 1);
+	cells = (int*) malloc(sizeof(int) * (vertex_mask + 1));
+	triangles = (int*) malloc(sizeof(int) * (triangle_mask + 1));
+
+	if(indices == NULL || remap == NULL || next == NULL || cells == NULL || triangles == NULL)
+	{
+		free(indices); free(remap); free(next); free(cells); free(triangles);
+		return 0;
+	}
+
+	for(i=0; i<mesh_o->index_count; i++)
+	{
+		if(mesh_o->index_size == 1)
+			indices[i] = ((const unsigned char*)mesh_o->indices)[i];
+		else if(mesh_o->index_size == 2)
+			indices[i] = ((const unsigned short*)mesh_o->indices)[i];
+		else
+			indices[i] = ((const unsigned int*)mesh_o->indices)[i];
+	}
+
+	//weld: every vertex is compared with the kept vertices of its own
+	//and the 26 neighbouring cells, listed per hashed cell
+	for(i=0; i<=(int)vertex_mask; i++)
+		cells[i] = MESH_CLEAN_NONE;
+
+	for(v=0; v<mesh_o->vertex_count; v++)
+	{
+		vertex = mesh_o->vertices + v * size;
+		x = mesh_clean_cell(vertex[0], epsilon);
+		y = mesh_clean_cell(vertex[1], epsilon);
+		z = mesh_clean_cell(vertex[2], epsilon);
+		remap[v] = MESH_CLEAN_NONE;
+
+		for(dz=-1; dz<=1 && remap[v] == MESH_CLEAN_NONE; dz++)
+		for(dy=-1; dy<=1 && remap[v] == MESH_CLEAN_NONE; dy++)
+		for(dx=-1; dx<=1 && remap[v] == MESH_CLEAN_NONE; dx++)
+		{
+			hash = mesh_clean_hash(x + dx, y + dy, z + dz) & vertex_mask;
+			for(w=cells[hash]; w != MESH_CLEAN_NONE; w=next[w])
+			{
+				if(mesh_clean_same_vertex(vertex, mesh_o->vertices + w * size, size, epsilon))
+				{
+					remap[v] = w;
+					break;
+				}
+			}
+		}
+
+		if(remap[v] != MESH_CLEAN_NONE)
+		{
+			welded++;
+			continue;
+		}
+
+		remap[v] = v;
+		hash = mesh_clean_hash(x, y, z) & vertex_mask;
+		next[v] = cells[hash];
+		cells[hash] = v;
+	}
+
+	//drop degenerate triangles and repeats; kept triangles are moved
+	//to the front of indices
+	for(i=0; i<=(int)triangle_mask; i++)
+		triangles[i] = MESH_CLEAN_NONE;
+
+	for(i=0; i<triangle_count; i++)
+	{
+		triangle = indices + 3 * kept;
+		triangle[0] = remap[indices[3*i]];
+		triangle[1] = remap[indices[3*i+1]];
+		triangle[2] = remap[indices[3*i+2]];
+
+		if(triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2] ||
+		   mesh_clean_is_thin(mesh_o->vertices + triangle[0] * size, mesh_o->vertices + triangle[1] * size,
+		                      mesh_o->vertices + triangle[2] * size, epsilon))
+		{
+			degenerate++;
+			continue;
+		}
+
+		mesh_clean_rotate(triangle, key);
+		for(hash = mesh_clean_hash(key[0], key[1], key[2]) & triangle_mask;
+		    triangles[hash] != MESH_CLEAN_NONE; hash = (hash + 1) & triangle_mask)
+		{
+			mesh_clean_rotate(indices + 3 * triangles[hash], other);
+			if(key[0] == other[0] && key[1] == other[1] && key[2] == other[2])
+				break;
+		}
+
+		if(triangles[hash] != MESH_CLEAN_NONE)
+		{
+			duplicate++;
+			continue;
+		}
+
+		triangles[hash] = kept++;
+	}
+
+	//compact: used vertices keep their order, next becomes the remap
+	for(v=0; v<mesh_o->vertex_count; v++)
+		next[v] = MESH_CLEAN_NONE;
+	for(i=0; i<3*kept; i++)
+		next[indices[i]] = 0;
+
+	for(v=0; v<mesh_o->vertex_count; v++)
+	{
+		if(next[v] == MESH_CLEAN_NONE)
+			continue;
+		if(count != v)
+			memcpy(mesh_o->vertices + count * size, mesh_o->vertices + v * size, sizeof(float) * size);
+		next[v] = count++;
+	}
+
+	if(report != NULL)
+	{
+		report->welded = welded;
+		report->unused = mesh_o->vertex_count - welded - count;
+		report->degenerate = degenerate;
+		report->duplicate = duplicate;
+	}
+
+	//fewer vertices never need wider indices, so they are narrowed in place
+	mesh_o->vertex_count = count;
+	mesh_o->index_count = 3 * kept;
+	mesh_o->index_size = mesh_index_size(count);
+	for(i=0; i<mesh_o->index_count; i++)
+	{
+		if(mesh_o->index_size == 1)
+			((unsigned char*)mesh_o->indices)[i] = (unsigned char)next[indices[i]];
+		else if(mesh_o->index_size == 2)
+			((unsigned short*)mesh_o->indices)[i] = (unsigned short)next[indices[i]];
+		else
+			((unsigned int*)mesh_o->indices)[i] = next[indices[i]];
+	}
+
+	if(mesh_o->storage == NULL)
+	{
+		shrunk = realloc(mesh_o->vertices, sizeof(float) * size * count + 1);
+		if(shrunk != NULL)
+			mesh_o->vertices = (float*) shrunk;
+		shrunk = realloc(mesh_o->indices, (size_t)mesh_o->index_size * mesh_o->index_count + 1);
+		if(shrunk != NULL)
+			mesh_o->indices = shrunk;
+	}
+	mesh_compute_bounds(mesh_o);
+
+	if(report != NULL)
+	{
+		report->bytes_before = bytes_before;
+		report->bytes_after = mesh_clean_bytes(mesh_o);
+		report->seconds = mesh_clean_seconds() - start;
+	}
+
+	free(indices); free(remap); free(next); free(cells); free(triangles);
+	return 1;
+}
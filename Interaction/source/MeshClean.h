@@ -0,0 +1,48 @@
+/******************************************************************
+*
+* MeshClean.h
+*
+* Description: Cleanup of parsed meshes before they are cooked.
+*
+*              Vertices closer than an epsilon in position, and with
+*              all other attributes within the epsilon as well, are
+*              welded into the first of them; candidates are found
+*              in a hashed grid of epsilon sized cells. Triangles
+*              left with two equal corners, thinner than the epsilon
+*              or repeating an earlier triangle with the same winding
+*              are dropped, and vertices no triangle uses are removed.
+*              Every step takes expected linear time.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __MESH_CLEAN_H
+#define __MESH_CLEAN_H
+
+#include <stddef.h>
+
+#include "Mesh.h"
+
+/* Default distance below which vertices are welded, in model units */
+#define MESH_CLEAN_EPSILON 1e-5f
+
+/* What mesh_clean removed */
+typedef struct
+{
+	int welded;                 //vertices merged into an earlier one
+	int unused;                 //vertices no triangle referenced
+	int degenerate;             //triangles without area
+	int duplicate;              //triangles repeating an earlier one
+	size_t bytes_before;        //vertex and index arrays
+	size_t bytes_after;
+	double seconds;
+} mesh_clean_report;
+
+int mesh_clean(mesh *mesh_o, float epsilon, mesh_clean_report *report);
+
+#endif
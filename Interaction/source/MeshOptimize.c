@@ -0,0 +1,294 @@
+/******************************************************************
+*
+* MeshOptimize.c
+*
+* Description: Reordering of mesh triangles for post-transform
+*              cache reuse and of vertices for fetch locality.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "MeshOptimize.h"
+
+#define MESH_UNUSED -1
+
+
+// internal helper functions
+double mesh_optimize_seconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+unsigned int mesh_optimize_get_index(const mesh *mesh_o, int i)
+{
+	if(mesh_o->index_size == 1)
+		return ((const unsigned char*)mesh_o->indices)[i];
+	if(mesh_o->index_size == 2)
+		return ((const unsigned short*)mesh_o->indices)[i];
+	return ((const unsigned int*)mesh_o->indices)[i];
+}
+
+void mesh_optimize_set_index(mesh *mesh_o, int i, unsigned int index)
+{
+	if(mesh_o->index_size == 1)
+		((unsigned char*)mesh_o->indices)[i] = (unsigned char)index;
+	else if(mesh_o->index_size == 2)
+		((unsigned short*)mesh_o->indices)[i] = (unsigned short)index;
+	else
+		((unsigned int*)mesh_o->indices)[i] = index;
+}
+
+/* Next vertex to fan around: the candidate with live triangles that
+ * is most likely still cached after its fan, else the newest vertex
+ * with live triangles on the dead-end stack, else the next one in
+ * input order */
+int mesh_optimize_next_vertex(const int *candidates, int candidate_count, const int *live,
+                              const int *stamps, int time, int cache_size,
+                              const int *dead_end, int *dead_end_count, int *cursor, int vertex_count)
+{
+	int best = MESH_UNUSED;
+	int best_priority = -1;
+	int priority;
+	int i, v;
+
+	for(i=0; i<candidate_count; i++)
+	{
+		v = candidates[i];
+		if(live[v] == 0)
+			continue;
+
+		//a fan of live[v] triangles adds at most 2 * live[v] vertices
+		priority = 0;
+		if(time - stamps[v] + 2 * live[v] <= cache_size)
+			priority = time - stamps[v];
+
+		if(priority > best_priority)
+		{
+			best = v;
+			best_priority = priority;
+		}
+	}
+	if(best != MESH_UNUSED)
+		return best;
+
+	while(*dead_end_count > 0)
+	{
+		v = dead_end[--*dead_end_count];
+		if(live[v] > 0)
+			return v;
+	}
+
+	for(; *cursor < vertex_count; ++*cursor)
+		if(live[*cursor] > 0)
+			return *cursor;
+
+	return MESH_UNUSED;
+}
+//end helpers
+
+
+/* Simulated FIFO cache: a vertex is cached while fewer than
+ * cache_size misses happened since its own */
+void mesh_optimize_analyze(const mesh *mesh_o, int cache_size, float *acmr, float *atvr)
+{
+	int *stamps;
+	int misses = 0;
+	int used = 0;
+	unsigned int v;
+	int i;
+
+	*acmr = 0.0f;
+	*atvr = 0.0f;
+	if(mesh_o->index_count == 0)
+		return;
+
+	stamps = (int*) malloc(sizeof(int) * mesh_o->vertex_count);
+	if(stamps == NULL)
+		return;
+	for(i=0; i<mesh_o->vertex_count; i++)
+		stamps[i] = MESH_UNUSED;
+
+	for(i=0; i<mesh_o->index_count; i++)
+	{
+		v = mesh_optimize_get_index(mesh_o, i);
+		if(stamps[v] == MESH_UNUSED)
+			used++;
+		else if(misses - stamps[v] < cache_size)
+			continue;
+
+		stamps[v] = ++misses;
+	}
+
+	*acmr = (float)misses / (mesh_o->index_count / 3);
+	*atvr = (float)misses / used;
+	free(stamps);
+}
+
+/* Tipsify: emit all live triangles around one vertex, then continue
+ * with a vertex of that fan still in the cache; linear in the size
+ * of the mesh */
+int mesh_optimize_triangles(mesh *mesh_o, int cache_size)
+{
+	int vertex_count = mesh_o->vertex_count;
+	int triangle_count = mesh_o->index_count / 3;
+	int *first, *adjacent, *live, *stamps, *dead_end;
+	unsigned int *output;
+	char *emitted;
+	int dead_end_count = 0;
+	int output_count = 0;
+	int time = cache_size + 1;
+	int cursor = 0;
+	int fan, fan_start;
+	int i, j, t, v;
+
+	if(triangle_count == 0)
+		return 1;
+
+	first = (int*) calloc(vertex_count + 1, sizeof(int));
+	adjacent = (int*) malloc(sizeof(int) * 3 * triangle_count);
+	live = (int*) calloc(vertex_count, sizeof(int));
+	stamps = (int*) calloc(vertex_count, sizeof(int));
+	dead_end = (int*) malloc(sizeof(int) * 3 * triangle_count);
+	output = (unsigned int*) malloc(sizeof(unsigned int) * 3 * triangle_count);
+	emitted = (char*) calloc(triangle_count, 1);
+
+	if(first == NULL || adjacent == NULL || live == NULL || stamps == NULL ||
+	   dead_end == NULL || output == NULL || emitted == NULL)
+	{
+		free(first); free(adjacent); free(live); free(stamps);
+		free(dead_end); free(output); free(emitted);
+		return 0;
+	}
+
+	//triangles of every vertex, grouped by a prefix sum over the counts
+	for(i=0; i<3*triangle_count; i++)
+		live[mesh_optimize_get_index(mesh_o, i)]++;
+	for(v=0; v<vertex_count; v++)
+		first[v+1] = first[v] + live[v];
+	for(i=0; i<3*triangle_count; i++)
+	{
+		v = mesh_optimize_get_index(mesh_o, i);
+		adjacent[first[v] + stamps[v]++] = i / 3;
+	}
+	memset(stamps, 0, sizeof(int) * vertex_count);
+
+	fan = 0;
+	while(fan != MESH_UNUSED)
+	{
+		//vertices of this fan are pushed on the dead-end stack and
+		//are the candidates for the next one
+		fan_start = dead_end_count;
+
+		for(i=first[fan]; i<first[fan+1]; i++)
+		{
+			t = adjacent[i];
+			if(emitted[t])
+				continue;
+
+			for(j=0; j<3; j++)
+			{
+				v = mesh_optimize_get_index(mesh_o, 3*t + j);
+				output[output_count++] = v;
+				dead_end[dead_end_count++] = v;
+				live[v]--;
+
+				if(time - stamps[v] > cache_size)
+					stamps[v] = time++;
+			}
+			emitted[t] = 1;
+		}
+
+		fan = mesh_optimize_next_vertex(dead_end + fan_start, dead_end_count - fan_start, live, stamps,
+		                                time, cache_size, dead_end, &dead_end_count, &cursor, vertex_count);
+	}
+
+	for(i=0; i<output_count; i++)
+		mesh_optimize_set_index(mesh_o, i, output[i]);
+
+	free(first); free(adjacent); free(live); free(stamps);
+	free(dead_end); free(output); free(emitted);
+	return 1;
+}
+
+/* Renumber vertices in order of first use; unused ones move to the end */
+int mesh_optimize_vertices(mesh *mesh_o)
+{
+	int *remap;
+	float *vertices;
+	size_t vertex_bytes = sizeof(float) * mesh_o->vertex_size;
+	int next = 0;
+	unsigned int v;
+	int i;
+
+	remap = (int*) malloc(sizeof(int) * mesh_o->vertex_count);
+	vertices = (float*) malloc(vertex_bytes * mesh_o->vertex_count);
+	if(remap == NULL || vertices == NULL)
+	{
+		free(remap);
+		free(vertices);
+		return 0;
+	}
+
+	for(i=0; i<mesh_o->vertex_count; i++)
+		remap[i] = MESH_UNUSED;
+
+	for(i=0; i<mesh_o->index_count; i++)
+	{
+		v = mesh_optimize_get_index(mesh_o, i);
+		if(remap[v] == MESH_UNUSED)
+			remap[v] = next++;
+		mesh_optimize_set_index(mesh_o, i, remap[v]);
+	}
+
+	for(i=0; i<mesh_o->vertex_count; i++)
+	{
+		if(remap[i] == MESH_UNUSED)
+			remap[i] = next++;
+		memcpy(vertices + remap[i] * mesh_o->vertex_size, mesh_o->vertices + i * mesh_o->vertex_size, vertex_bytes);
+	}
+	memcpy(mesh_o->vertices, vertices, vertex_bytes * mesh_o->vertex_count);
+
+	free(remap);
+	free(vertices);
+	return 1;
+}
+
+/* Both reorderings, with the cache reuse before and after */
+int mesh_optimize(mesh *mesh_o, mesh_optimize_report *report)
+{
+	double start = mesh_optimize_seconds();
+	float acmr, atvr;
+
+	if(report != NULL)
+	{
+		mesh_optimize_analyze(mesh_o, MESH_OPTIMIZE_CACHE_SIZE, &acmr, &atvr);
+		report->acmr_before = acmr;
+		report->atvr_before = atvr;
+		start = mesh_optimize_seconds();
+	}
+
+	if(!mesh_optimize_triangles(mesh_o, MESH_OPTIMIZE_CACHE_SIZE) || !mesh_optimize_vertices(mesh_o))
+		return 0;
+
+	if(report != NULL)
+	{
+		report->seconds = mesh_optimize_seconds() - start;
+		mesh_optimize_analyze(mesh_o, MESH_OPTIMIZE_CACHE_SIZE, &acmr, &atvr);
+		report->acmr_after = acmr;
+		report->atvr_after = atvr;
+	}
+
+	return 1;
+}
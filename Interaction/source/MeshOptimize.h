@@ -0,0 +1,51 @@
+/******************************************************************
+*
+* MeshOptimize.h
+*
+* Description: Reordering of mesh triangles and vertices for the
+*              GPU, done once before a mesh is cooked.
+*
+*              Triangles are put into the order of the Tipsify
+*              algorithm (Sander, Nehab and Barczak 2007), fanning
+*              around recently used vertices so they are still in
+*              the post-transform cache. Vertices are then stored in
+*              the order they are first used, so vertex fetch walks
+*              the buffer front to back. Neither changes the set of
+*              triangles or their winding.
+*
+*              Cache reuse is measured on a FIFO cache as ACMR,
+*              transformed vertices per triangle (0.5 at best), and
+*              ATVR, transformed vertices per used vertex (1 at best).
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __MESH_OPTIMIZE_H
+#define __MESH_OPTIMIZE_H
+
+#include "Mesh.h"
+
+/* Entries of the simulated and targeted post-transform cache */
+#define MESH_OPTIMIZE_CACHE_SIZE 16
+
+/* Reuse before and after mesh_optimize */
+typedef struct
+{
+	float acmr_before;
+	float atvr_before;
+	float acmr_after;
+	float atvr_after;
+	double seconds;
+} mesh_optimize_report;
+
+void mesh_optimize_analyze(const mesh *mesh_o, int cache_size, float *acmr, float *atvr);
+int mesh_optimize_triangles(mesh *mesh_o, int cache_size);
+int mesh_optimize_vertices(mesh *mesh_o);
+int mesh_optimize(mesh *mesh_o, mesh_optimize_report *report);
+
+#endif
@@ -0,0 +1,700 @@
+/******************************************************************
+*
+* MeshSimplify.c
+*
+* Description: Quadric error metric simplification by half-edge
+*              collapses and the levels of detail built with it.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "MeshSimplify.h"
+#include "MeshOptimize.h"
+
+#define MESH_SIMPLIFY_NONE -1
+#define MESH_SIMPLIFY_MAX_PASSES 64
+
+/* Collapse of one position onto a neighbour */
+typedef struct
+{
+	double cost;
+	int from;
+	int to;
+} mesh_simplify_collapse;
+
+/* Positions of a mesh with their vertices, quadrics and triangles */
+typedef struct
+{
+	const mesh *source;
+	int position_count;
+	int *position_of;           //per vertex
+	int *first_vertex;          //per position, vertices listed through next_vertex
+	int *next_vertex;
+	double *quadrics;           //10 per position
+	char *locked;               //on a border or a non-manifold edge
+	int *first_triangle;        //per position, into triangle_list
+	int *triangle_list;
+	int *collapse_to;           //per position during a pass
+	int *marks;
+	char *touched;
+} mesh_simplify_state;
+
+
+// internal helper functions
+double mesh_simplify_seconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+unsigned int mesh_simplify_get_index(const mesh *mesh_o, int i)
+{
+	if(mesh_o->index_size == 1)
+		return ((const unsigned char*)mesh_o->indices)[i];
+	if(mesh_o->index_size == 2)
+		return ((const unsigned short*)mesh_o->indices)[i];
+	return ((const unsigned int*)mesh_o->indices)[i];
+}
+
+unsigned int mesh_simplify_table_size(int count)
+{
+	unsigned int size = 16;
+
+	while(size < (unsigned int)count*2)
+		size *= 2;
+	return size;
+}
+
+const float* mesh_simplify_point(const mesh_simplify_state *state, int position)
+{
+	return state->source->vertices + state->first_vertex[position] * state->source->vertex_size;
+}
+
+void mesh_simplify_normal(const float *a, const float *b, const float *c, double *normal)
+{
+	double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+	double ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+
+	normal[0] = ab[1]*ac[2] - ab[2]*ac[1];
+	normal[1] = ab[2]*ac[0] - ab[0]*ac[2];
+	normal[2] = ab[0]*ac[1] - ab[1]*ac[0];
+}
+
+/* Quadric of the plane of a triangle: squared distance to the plane */
+void mesh_simplify_add_plane(double *quadric, const float *a, const float *b, const float *c)
+{
+	double normal[3], length, d;
+
+	mesh_simplify_normal(a, b, c, normal);
+	length = sqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+	if(length == 0.0)
+		return;
+
+	normal[0] /= length;
+	normal[1] /= length;
+	normal[2] /= length;
+	d = -(normal[0]*a[0] + normal[1]*a[1] + normal[2]*a[2]);
+
+	quadric[0] += normal[0]*normal[0];
+	quadric[1] += normal[0]*normal[1];
+	quadric[2] += normal[0]*normal[2];
+	quadric[3] += normal[0]*d;
+	quadric[4] += normal[1]*normal[1];
+	quadric[5] += normal[1]*normal[2];
+	quadric[6] += normal[1]*d;
+	quadric[7] += normal[2]*normal[2];
+	quadric[8] += normal[2]*d;
+	quadric[9] += d*d;
+}
+
+double mesh_simplify_evaluate(const double *q, const float *p)
+{
+	double x = p[0], y = p[1], z = p[2];
+
+	return q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x +
+	       q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y +
+	       q[7]*z*z + 2*q[8]*z + q[9];
+}
+
+int mesh_simplify_compare(const void *a, const void *b)
+{
+	double cost_a = ((const mesh_simplify_collapse*)a)->cost;
+	double cost_b = ((const mesh_simplify_collapse*)b)->cost;
+
+	return cost_a < cost_b ? -1 : cost_a > cost_b;
+}
+
+/* Vertices with bitwise equal positions share one position */
+int mesh_simplify_positions(mesh_simplify_state *state)
+{
+	const mesh *source = state->source;
+	unsigned int mask = mesh_simplify_table_size(source->vertex_count) - 1;
+	unsigned int *bits, hash;
+	int *slots;
+	int v, p;
+
+	slots = (int*) malloc(sizeof(int) * (mask + 1));
+	if(slots == NULL)
+		return 0;
+	for(hash=0; hash<=mask; hash++)
+		slots[hash] = MESH_SIMPLIFY_NONE;
+
+	state->position_count = 0;
+	for(v=0; v<source->vertex_count; v++)
+	{
+		bits = (unsigned int*)(source->vertices + v * source->vertex_size);
+		hash = bits[0]*0x9e3779b1u ^ bits[1]*0x85ebca77u ^ bits[2]*0xc2b2ae3du;
+		hash ^= hash >> 16;
+
+		for(hash &= mask; slots[hash] != MESH_SIMPLIFY_NONE; hash = (hash + 1) & mask)
+			if(memcmp(bits, mesh_simplify_point(state, slots[hash]), sizeof(float) * 3) == 0)
+				break;
+
+		p = slots[hash];
+		if(p == MESH_SIMPLIFY_NONE)
+		{
+			p = slots[hash] = state->position_count++;
+			state->first_vertex[p] = v;
+			state->next_vertex[v] = MESH_SIMPLIFY_NONE;
+		}
+		else
+		{
+			//the first vertex stays the head, it gives the point
+			state->next_vertex[v] = state->next_vertex[state->first_vertex[p]];
+			state->next_vertex[state->first_vertex[p]] = v;
+		}
+		state->position_of[v] = p;
+	}
+
+	free(slots);
+	return 1;
+}
+
+/* Lock both ends of edges used by one triangle or by more than two */
+int mesh_simplify_lock_borders(mesh_simplify_state *state, const unsigned int *triangles, int triangle_count)
+{
+	unsigned int mask = mesh_simplify_table_size(3 * triangle_count) - 1;
+	unsigned int hash;
+	int *keys, *counts;
+	int a, b, i, j;
+
+	keys = (int*) malloc(sizeof(int) * 2 * (mask + 1));
+	counts = (int*) calloc(mask + 1, sizeof(int));
+	if(keys == NULL || counts == NULL)
+	{
+		free(keys);
+		free(counts);
+		return 0;
+	}
+
+	for(i=0; i<3*triangle_count; i++)
+	{
+		j = i - i % 3 + (i + 1) % 3;
+		a = state->position_of[triangles[i]];
+		b = state->position_of[triangles[j]];
+		if(a > b)
+		{
+			j = a; a = b; b = j;
+		}
+
+		hash = ((unsigned int)a*0x9e3779b1u ^ (unsigned int)b*0x85ebca77u);
+		for(hash = (hash ^ (hash >> 16)) & mask; counts[hash] != 0; hash = (hash + 1) & mask)
+			if(keys[2*hash] == a && keys[2*hash+1] == b)
+				break;
+
+		keys[2*hash] = a;
+		keys[2*hash+1] = b;
+		counts[hash]++;
+	}
+
+	for(hash=0; hash<=mask; hash++)
+	{
+		if(counts[hash] != 0 && counts[hash] != 2)
+		{
+			state->locked[keys[2*hash]] = 1;
+			state->locked[keys[2*hash+1]] = 1;
+		}
+	}
+
+	free(keys);
+	free(counts);
+	return 1;
+}
+
+/* Triangles around every position, grouped by a prefix sum; uses
+ * collapse_to as the fill cursor */
+void mesh_simplify_adjacency(mesh_simplify_state *state, const unsigned int *triangles, int triangle_count)
+{
+	int i, p;
+
+	memset(state->first_triangle, 0, sizeof(int) * (state->position_count + 1));
+	for(i=0; i<3*triangle_count; i++)
+		state->first_triangle[state->position_of[triangles[i]] + 1]++;
+	for(p=0; p<state->position_count; p++)
+	{
+		state->first_triangle[p+1] += state->first_triangle[p];
+		state->collapse_to[p] = state->first_triangle[p];
+	}
+
+	for(i=0; i<3*triangle_count; i++)
+		state->triangle_list[state->collapse_to[state->position_of[triangles[i]]]++] = i / 3;
+}
+
+/* Moving from onto to must not flip a remaining triangle, and the
+ * positions next to both must be exactly the tips of the removed
+ * triangles, otherwise the surface would fold or pinch */
+int mesh_simplify_allowed(mesh_simplify_state *state, const unsigned int *triangles, int from, int to,
+                          int stamp, int *removed)
+{
+	const float *points[3];
+	double before[3], after[3];
+	int shared = 0, common = 0;
+	int i, j, t, p, q;
+
+	for(i=state->first_triangle[from]; i<state->first_triangle[from+1]; i++)
+	{
+		t = state->triangle_list[i];
+		q = MESH_SIMPLIFY_NONE;
+		for(j=0; j<3; j++)
+		{
+			p = state->position_of[triangles[3*t+j]];
+			if(p == to)
+				q = to;
+			else if(p != from)
+				state->marks[p] = stamp;
+		}
+
+		if(q == to)
+		{
+			shared++;
+			continue;
+		}
+
+		for(j=0; j<3; j++)
+			points[j] = mesh_simplify_point(state, state->position_of[triangles[3*t+j]]);
+		mesh_simplify_normal(points[0], points[1], points[2], before);
+
+		for(j=0; j<3; j++)
+			if(state->position_of[triangles[3*t+j]] == from)
+				points[j] = mesh_simplify_point(state, to);
+		mesh_simplify_normal(points[0], points[1], points[2], after);
+
+		if(before[0]*after[0] + before[1]*after[1] + before[2]*after[2] <= 0.0)
+			return 0;
+	}
+
+	for(i=state->first_triangle[to]; i<state->first_triangle[to+1]; i++)
+	{
+		t = state->triangle_list[i];
+		for(j=0; j<3; j++)
+		{
+			p = state->position_of[triangles[3*t+j]];
+			if(p != to && p != from && state->marks[p] == stamp)
+			{
+				state->marks[p] = -stamp;
+				common++;
+			}
+		}
+	}
+
+	*removed = shared;
+	return shared > 0 && common == shared;
+}
+
+/* Position ids of a triangle, rotated to start at the smallest with
+ * the winding kept */
+void mesh_simplify_triangle_key(const mesh_simplify_state *state, const unsigned int *triangle, int *key)
+{
+	int a = state->position_of[triangle[0]];
+	int b = state->position_of[triangle[1]];
+	int c = state->position_of[triangle[2]];
+
+	if(a <= b && a <= c)
+	{
+		key[0] = a; key[1] = b; key[2] = c;
+	}
+	else if(b <= a && b <= c)
+	{
+		key[0] = b; key[1] = c; key[2] = a;
+	}
+	else
+	{
+		key[0] = c; key[1] = a; key[2] = b;
+	}
+}
+
+/* Triangles of indices except those repeating the positions of an
+ * earlier one with the same winding, as a surface stored once per
+ * set of normals has them; the copies would make every edge of the
+ * surface non-manifold and lock it. Returns the number of indices in
+ * result, -1 if out of memory */
+int mesh_simplify_surface(const mesh *mesh_o, const unsigned int *indices, int index_count, unsigned int *result)
+{
+	mesh_simplify_state state;
+	unsigned int mask = mesh_simplify_table_size(index_count / 3) - 1;
+	unsigned int hash;
+	int *slots = NULL;
+	int key[3], other[3];
+	int kept = -1, i;
+
+	memset(&state, 0, sizeof(state));
+	state.source = mesh_o;
+	state.position_of = (int*) malloc(sizeof(int) * mesh_o->vertex_count + 1);
+	state.first_vertex = (int*) malloc(sizeof(int) * mesh_o->vertex_count + 1);
+	state.next_vertex = (int*) malloc(sizeof(int) * mesh_o->vertex_count + 1);
+	slots = (int*) malloc(sizeof(int) * (mask + 1));
+
+	if(state.position_of == NULL || state.first_vertex == NULL || state.next_vertex == NULL ||
+	   slots == NULL || !mesh_simplify_positions(&state))
+		goto done;
+
+	for(hash=0; hash<=mask; hash++)
+		slots[hash] = MESH_SIMPLIFY_NONE;
+
+	kept = 0;
+	for(i=0; i<index_count/3; i++)
+	{
+		mesh_simplify_triangle_key(&state, indices + 3*i, key);
+		hash = (unsigned int)key[0]*0x9e3779b1u ^ (unsigned int)key[1]*0x85ebca77u ^ (unsigned int)key[2]*0xc2b2ae3du;
+		for(hash = (hash ^ (hash >> 16)) & mask; slots[hash] != MESH_SIMPLIFY_NONE; hash = (hash + 1) & mask)
+		{
+			mesh_simplify_triangle_key(&state, result + 3*slots[hash], other);
+			if(key[0] == other[0] && key[1] == other[1] && key[2] == other[2])
+				break;
+		}
+		if(slots[hash] != MESH_SIMPLIFY_NONE)
+			continue;
+
+		slots[hash] = kept;
+		memcpy(result + 3*kept, indices + 3*i, sizeof(unsigned int) * 3);
+		kept++;
+	}
+	kept *= 3;
+
+done:
+	free(state.position_of);
+	free(state.first_vertex);
+	free(state.next_vertex);
+	free(slots);
+	return kept;
+}
+
+/* Vertex at position with the attributes closest to vertex */
+int mesh_simplify_closest_vertex(const mesh_simplify_state *state, int vertex, int position)
+{
+	const mesh *source = state->source;
+	const float *a = source->vertices + vertex * source->vertex_size;
+	const float *b;
+	float distance, best_distance = 0.0f;
+	int best = state->first_vertex[position];
+	int v, i;
+
+	for(v=best; v != MESH_SIMPLIFY_NONE && source->vertex_size > 3; v=state->next_vertex[v])
+	{
+		b = source->vertices + v * source->vertex_size;
+		distance = 0.0f;
+		for(i=3; i<source->vertex_size; i++)
+			distance += (a[i] - b[i]) * (a[i] - b[i]);
+
+		if(v == state->first_vertex[position] || distance < best_distance)
+		{
+			best = v;
+			best_distance = distance;
+		}
+	}
+
+	return best;
+}
+//end helpers
+
+
+/* Simplify the triangles in indices towards target_index_count; the
+ * result holds at most index_count indices into the vertices of
+ * mesh_o. Returns the number of indices in result, 0 if out of memory */
+int mesh_simplify(const mesh *mesh_o, const unsigned int *indices, int index_count,
+                  int target_index_count, unsigned int *result, float *error)
+{
+	mesh_simplify_state state;
+	mesh_simplify_collapse *candidates = NULL;
+	int vertex_count = mesh_o->vertex_count;
+	int triangle_count = index_count / 3;
+	int target = target_index_count / 3;
+	int candidate_count, removed, shared, pass, stamp = 0;
+	double plane[10];
+	double largest = 0.0, cost, best_cost;
+	const float *point;
+	int i, j, k, p, q, best, kept, success = 0;
+
+	*error = 0.0f;
+	memcpy(result, indices, sizeof(unsigned int) * 3 * triangle_count);
+
+	memset(&state, 0, sizeof(state));
+	state.source = mesh_o;
+	state.position_of = (int*) malloc(sizeof(int) * vertex_count + 1);
+	state.first_vertex = (int*) malloc(sizeof(int) * vertex_count + 1);
+	state.next_vertex = (int*) malloc(sizeof(int) * vertex_count + 1);
+	state.quadrics = (double*) calloc(10 * (size_t)vertex_count + 1, sizeof(double));
+	state.locked = (char*) calloc(vertex_count + 1, 1);
+	state.first_triangle = (int*) malloc(sizeof(int) * (vertex_count + 1));
+	state.triangle_list = (int*) malloc(sizeof(int) * 3 * triangle_count + 1);
+	state.collapse_to = (int*) malloc(sizeof(int) * vertex_count + 1);
+	state.marks = (int*) calloc(vertex_count + 1, sizeof(int));
+	state.touched = (char*) malloc(vertex_count + 1);
+	candidates = (mesh_simplify_collapse*) malloc(sizeof(mesh_simplify_collapse) * vertex_count + 1);
+
+	if(state.position_of == NULL || state.first_vertex == NULL || state.next_vertex == NULL ||
+	   state.quadrics == NULL || state.locked == NULL || state.first_triangle == NULL ||
+	   state.triangle_list == NULL || state.collapse_to == NULL || state.marks == NULL ||
+	   state.touched == NULL || candidates == NULL ||
+	   !mesh_simplify_positions(&state) || !mesh_simplify_lock_borders(&state, result, triangle_count))
+		goto done;
+
+	for(i=0; i<triangle_count; i++)
+	{
+		memset(plane, 0, sizeof(plane));
+		mesh_simplify_add_plane(plane, mesh_simplify_point(&state, state.position_of[result[3*i]]),
+		                        mesh_simplify_point(&state, state.position_of[result[3*i+1]]),
+		                        mesh_simplify_point(&state, state.position_of[result[3*i+2]]));
+		for(j=0; j<3; j++)
+			for(k=0; k<10; k++)
+				state.quadrics[10 * state.position_of[result[3*i+j]] + k] += plane[k];
+	}
+
+	//every pass collapses the cheapest edges whose surroundings no
+	//other collapse of the pass touched, then rebuilds the triangles
+	for(pass=0; pass<MESH_SIMPLIFY_MAX_PASSES && triangle_count > target; pass++)
+	{
+		mesh_simplify_adjacency(&state, result, triangle_count);
+
+		candidate_count = 0;
+		for(p=0; p<state.position_count; p++)
+		{
+			state.collapse_to[p] = MESH_SIMPLIFY_NONE;
+			state.touched[p] = 0;
+			if(state.locked[p])
+				continue;
+
+			best = MESH_SIMPLIFY_NONE;
+			best_cost = 0.0;
+			for(i=state.first_triangle[p]; i<state.first_triangle[p+1]; i++)
+			{
+				for(j=0; j<3; j++)
+				{
+					q = state.position_of[result[3*state.triangle_list[i]+j]];
+					if(q == p)
+						continue;
+
+					point = mesh_simplify_point(&state, q);
+					cost = mesh_simplify_evaluate(state.quadrics + 10*p, point) +
+					       mesh_simplify_evaluate(state.quadrics + 10*q, point);
+					if(best == MESH_SIMPLIFY_NONE || cost < best_cost)
+					{
+						best = q;
+						best_cost = cost;
+					}
+				}
+			}
+
+			if(best != MESH_SIMPLIFY_NONE)
+			{
+				candidates[candidate_count].cost = best_cost;
+				candidates[candidate_count].from = p;
+				candidates[candidate_count].to = best;
+				candidate_count++;
+			}
+		}
+		qsort(candidates, candidate_count, sizeof(mesh_simplify_collapse), mesh_simplify_compare);
+
+		//only the cheaper half, so costs stay close to a global order
+		removed = 0;
+		kept = 0;
+		for(k=0; k<(candidate_count + 1) / 2 && triangle_count - removed > target; k++)
+		{
+			p = candidates[k].from;
+			q = candidates[k].to;
+			if(state.touched[p] || state.touched[q] ||
+			   !mesh_simplify_allowed(&state, result, p, q, ++stamp, &shared))
+				continue;
+
+			state.collapse_to[p] = q;
+			for(j=0; j<10; j++)
+				state.quadrics[10*q + j] += state.quadrics[10*p + j];
+
+			state.touched[q] = 1;
+			for(i=state.first_triangle[p]; i<state.first_triangle[p+1]; i++)
+				for(j=0; j<3; j++)
+					state.touched[state.position_of[result[3*state.triangle_list[i]+j]]] = 1;
+
+			removed += shared;
+			if(candidates[k].cost > largest)
+				largest = candidates[k].cost;
+			kept++;
+		}
+		if(kept == 0)
+			break;
+
+		//corners of collapsed positions move on, triangles left with
+		//two corners at one position are dropped
+		kept = 0;
+		for(i=0; i<triangle_count; i++)
+		{
+			for(j=0; j<3; j++)
+			{
+				p = state.position_of[result[3*i+j]];
+				if(state.collapse_to[p] != MESH_SIMPLIFY_NONE)
+					result[3*kept+j] = mesh_simplify_closest_vertex(&state, result[3*i+j], state.collapse_to[p]);
+				else
+					result[3*kept+j] = result[3*i+j];
+			}
+
+			p = state.position_of[result[3*kept]];
+			q = state.position_of[result[3*kept+1]];
+			j = state.position_of[result[3*kept+2]];
+			if(p != q && q != j && p != j)
+				kept++;
+		}
+		triangle_count = kept;
+	}
+
+	*error = (float)sqrt(largest > 0.0 ? largest : 0.0);
+	success = 1;
+
+done:
+	free(state.position_of);
+	free(state.first_vertex);
+	free(state.next_vertex);
+	free(state.quadrics);
+	free(state.locked);
+	free(state.first_triangle);
+	free(state.triangle_list);
+	free(state.collapse_to);
+	free(state.marks);
+	free(state.touched);
+	free(candidates);
+	return success ? 3 * triangle_count : 0;
+}
+
+/* Append coarser levels to the indices until they stop shrinking;
+ * each level is reordered for the vertex cache. Meshes pointing into
+ * a shared block or holding levels already are left alone */
+int mesh_simplify_lods(mesh *mesh_o, mesh_simplify_report *report)
+{
+	double start = mesh_simplify_seconds();
+	unsigned int *indices, *grown, *surface, *source;
+	mesh_lod *last, *level;
+	mesh view;
+	int capacity = mesh_o->index_count;
+	int used = mesh_o->index_count;
+	int target, count, source_count, i;
+	float error;
+	void *narrowed;
+
+	if(mesh_o->storage != NULL || mesh_o->lod_count > 0)
+		return 0;
+
+	indices = (unsigned int*) malloc(sizeof(unsigned int) * capacity + 1);
+	surface = (unsigned int*) malloc(sizeof(unsigned int) * capacity + 1);
+	if(indices == NULL || surface == NULL)
+	{
+		free(indices);
+		free(surface);
+		return 0;
+	}
+	for(i=0; i<mesh_o->index_count; i++)
+		indices[i] = mesh_simplify_get_index(mesh_o, i);
+
+	//the full level keeps every triangle; the coarser ones start from
+	//the surface with copies at the same positions left out
+	count = mesh_simplify_surface(mesh_o, indices, mesh_o->index_count, surface);
+
+	mesh_o->lods[0].first_index = 0;
+	mesh_o->lods[0].index_count = mesh_o->index_count;
+	mesh_o->lods[0].error = 0.0f;
+	mesh_o->lod_count = 1;
+
+	while(count >= 0 && mesh_o->lod_count < MESH_MAX_LODS)
+	{
+		last = &mesh_o->lods[mesh_o->lod_count - 1];
+		source = mesh_o->lod_count == 1 ? surface : indices + last->first_index;
+		source_count = mesh_o->lod_count == 1 ? count : last->index_count;
+		target = (int)(last->index_count / 3 * MESH_SIMPLIFY_RATIO) * 3;
+		if(target / 3 < MESH_SIMPLIFY_MIN_TRIANGLES)
+			break;
+
+		//a level never has more indices than the one before
+		if(used + last->index_count > capacity)
+		{
+			capacity = 2 * capacity > used + last->index_count ? 2 * capacity : used + last->index_count;
+			grown = (unsigned int*) realloc(indices, sizeof(unsigned int) * capacity);
+			if(grown == NULL)
+				break;
+			indices = grown;
+		}
+
+		count = mesh_simplify(mesh_o, source, source_count, target, indices + used, &error);
+		if(count == 0 || count > last->index_count * MESH_SIMPLIFY_MIN_REDUCTION)
+			break;
+
+		//errors of the levels add up relative to the full mesh
+		level = &mesh_o->lods[mesh_o->lod_count++];
+		level->first_index = used;
+		level->index_count = count;
+		level->error = last->error + error;
+
+		view = *mesh_o;
+		view.indices = indices + used;
+		view.index_count = count;
+		view.index_size = sizeof(unsigned int);
+		mesh_optimize_triangles(&view, MESH_OPTIMIZE_CACHE_SIZE);
+
+		used += count;
+	}
+
+	free(surface);
+
+	//all levels in the index size of the mesh
+	narrowed = realloc(mesh_o->indices, (size_t)mesh_o->index_size * used + 1);
+	if(narrowed == NULL)
+	{
+		free(indices);
+		mesh_o->lod_count = 0;
+		return 0;
+	}
+	mesh_o->indices = narrowed;
+	for(i=0; i<used; i++)
+	{
+		if(mesh_o->index_size == 1)
+			((unsigned char*)mesh_o->indices)[i] = (unsigned char)indices[i];
+		else if(mesh_o->index_size == 2)
+			((unsigned short*)mesh_o->indices)[i] = (unsigned short)indices[i];
+		else
+			((unsigned int*)mesh_o->indices)[i] = indices[i];
+	}
+	mesh_o->index_count = used;
+	free(indices);
+
+	if(report != NULL)
+	{
+		report->lod_count = mesh_o->lod_count;
+		for(i=0; i<mesh_o->lod_count; i++)
+		{
+			report->triangle_count[i] = mesh_o->lods[i].index_count / 3;
+			report->error[i] = mesh_o->lods[i].error;
+		}
+		report->seconds = mesh_simplify_seconds() - start;
+	}
+
+	return 1;
+}
@@ -0,0 +1,58 @@
+/******************************************************************
+*
+* MeshSimplify.h
+*
+* Description: Levels of detail built by quadric error metric
+*              simplification (Garland and Heckbert 1997).
+*
+*              Every position carries the quadric of the planes of
+*              its triangles. An edge is collapsed by moving one end
+*              onto the other (half-edge collapse), so no vertex is
+*              created and all levels index the vertex array of the
+*              full mesh. Corners of a removed position take the
+*              vertex at the remaining position with the closest
+*              normal and texture coordinates. Positions on borders
+*              stay in place, and collapses that would flip a
+*              triangle are skipped. Triangles repeating the
+*              positions of another, such as a surface stored once
+*              per set of normals, are left out of the coarser levels.
+*
+*              Each level aims at half the triangles of the one
+*              before; its error is the square root of the largest
+*              collapse cost, in model units.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __MESH_SIMPLIFY_H
+#define __MESH_SIMPLIFY_H
+
+#include "Mesh.h"
+
+/* Triangles of a level relative to the level before */
+#define MESH_SIMPLIFY_RATIO 0.5f
+
+/* No further level if it would keep more than this of the last one */
+#define MESH_SIMPLIFY_MIN_REDUCTION 0.8f
+
+/* No levels below this many triangles */
+#define MESH_SIMPLIFY_MIN_TRIANGLES 8
+
+typedef struct
+{
+	int lod_count;
+	int triangle_count[MESH_MAX_LODS];
+	float error[MESH_MAX_LODS];
+	double seconds;
+} mesh_simplify_report;
+
+int mesh_simplify(const mesh *mesh_o, const unsigned int *indices, int index_count,
+                  int target_index_count, unsigned int *result, float *error);
+int mesh_simplify_lods(mesh *mesh_o, mesh_simplify_report *report);
+
+#endif
@@ -24,7 +24,52 @@
 #include <stdlib.h>
 
 #include "OBJParser.h"
-#define WHITESPACE " \t\n\r"
+#include "OBJReader.h"
+#include "OBJScan.h"
+#include "ThreadPool.h"
+
+#define OBJ_MATERIAL_INHERIT -2  //face precedes the first usemtl of its chunk
+#define OBJ_RELATIVE_VERTEX  0x001
+#define OBJ_RELATIVE_TEXTURE 0x010
+#define OBJ_RELATIVE_NORMAL  0x100
+
+typedef struct
+{
+	int face;
+	int mask;
+} obj_relative_face;
+
+VECTOR_DECLARE(obj_relative_faces, obj_relative_face)
+
+/* State of one newline aligned slice of a file parsed by
+ * parse_obj_scene_parallel; indices and materials are chunk local
+ * until the fix-up pass has run */
+typedef struct
+{
+	obj_growable_scene_data scene;
+	obj_reader reader;
+	name_pool material_names;
+	obj_relative_faces relative_faces;
+	int final_material;
+	int mtllib_count;
+	char has_usemtl;
+	char usemtl_before_mtllib;
+	char unsupported;
+
+	int vertex_offset;
+	int texture_offset;
+	int normal_offset;
+	int inherited_material;
+	int *material_remap;
+} obj_parse_chunk;
+
+/* Indices of every corner of one face line, as written in the file */
+typedef struct
+{
+	int_vector vertex_index;
+	int_vector texture_index;
+	int_vector normal_index;
+} obj_corners;
 
 
 
@@ -32,6 +77,8 @@ void obj_free_half_list(list *listo)
 {
 	list_delete_all(listo);
 	free(listo->names);
+	free(listo->name_slots);
+	free(listo->name_hashes);
 }
 
 int obj_convert_to_list_index(int current_max, int index)
@@ -71,39 +118,39 @@ void obj_set_material_defaults(obj_material *mtl)
 	mtl->texture_filename[0] = '\0';
 }
 
-int obj_parse_vertex_index(int *vertex_index, int *texture_index, int *normal_index)
+double obj_parse_double(obj_line *line)
+{
+	obj_token token;
+
+	if( !obj_line_next_token(line, &token) )
+		return 0.0;
+	return obj_scan_double(token.begin, token.begin + token.length);
+}
+
+int obj_parse_vertex_index(obj_line *line, int *vertex_index, int *texture_index, int *normal_index)
 {
-	char *temp_str;
-	char *token;
+	obj_token token;
+	int texture, normal;
 	int vertex_count = 0;
+	int i;
 
-	
-	while( (token = strtok(NULL, WHITESPACE)) != NULL)
+	for(i=0; i<MAX_VERTEX_COUNT; i++)
 	{
+		vertex_index[i] = 0;
 		if(texture_index != NULL)
-			texture_index[vertex_count] = 0;
+			texture_index[i] = 0;
 		if(normal_index != NULL)
-		normal_index[vertex_count] = 0;
-
-		vertex_index[vertex_count] = atoi( token );
-		
-		if(contains(token, "//"))  //normal only
-		{
-			temp_str = strchr(token, '/');
-			temp_str++;
-			normal_index[vertex_count] = atoi( ++temp_str );
-		}
-		else if(contains(token, "/"))
-		{
-			temp_str = strchr(token, '/');
-			texture_index[vertex_count] = atoi( ++temp_str );
+			normal_index[i] = 0;
+	}
+	
+	while( vertex_count < MAX_VERTEX_COUNT && obj_line_next_token(line, &token) )
+	{
+		obj_scan_index(token.begin, token.begin + token.length, &vertex_index[vertex_count], &texture, &normal);
 
-			if(contains(temp_str, "/"))
-			{
-				temp_str = strchr(temp_str, '/');
-				normal_index[vertex_count] = atoi( ++temp_str );
-			}
-		}
+		if(texture_index != NULL)
+			texture_index[vertex_count] = texture;
+		if(normal_index != NULL)
+			normal_index[vertex_count] = normal;
 		
 		vertex_count++;
 	}
@@ -111,216 +158,481 @@ int obj_parse_vertex_index(int *vertex_index, int *texture_index, int *normal_in
 	return vertex_count;
 }
 
-obj_face* obj_parse_face(obj_growable_scene_data *scene)
+void obj_add_relative_face(obj_parse_chunk *chunk, int face, int mask)
 {
-	int vertex_count;
-	obj_face *face = (obj_face*)malloc(sizeof(obj_face));
-	
-	vertex_count = obj_parse_vertex_index(face->vertex_index, face->texture_index, face->normal_index);
-	obj_convert_to_list_index_v(scene->vertex_list.item_count, face->vertex_index);
-	obj_convert_to_list_index_v(scene->vertex_texture_list.item_count, face->texture_index);
-	obj_convert_to_list_index_v(scene->vertex_normal_list.item_count, face->normal_index);
-	face->vertex_count = vertex_count;
-	return face;
+	obj_relative_face *relative = obj_relative_faces_push(&chunk->relative_faces);
+	relative->face = face;
+	relative->mask = mask;
+}
+
+int obj_relative_index_mask(obj_face *face)
+{
+	int i;
+	int mask = 0;
+
+	for(i=0; i<MAX_VERTEX_COUNT; i++)
+	{
+		if(face->vertex_index[i] < 0)
+			mask |= OBJ_RELATIVE_VERTEX << i;
+		if(face->texture_index[i] < 0)
+			mask |= OBJ_RELATIVE_TEXTURE << i;
+		if(face->normal_index[i] < 0)
+			mask |= OBJ_RELATIVE_NORMAL << i;
+	}
+
+	return mask;
 }
 
-obj_sphere* obj_parse_sphere(obj_growable_scene_data *scene)
+void obj_corners_make(obj_corners *corners)
+{
+	int_vector_make(&corners->vertex_index, MAX_VERTEX_COUNT);
+	int_vector_make(&corners->texture_index, MAX_VERTEX_COUNT);
+	int_vector_make(&corners->normal_index, MAX_VERTEX_COUNT);
+}
+
+void obj_corners_free(obj_corners *corners)
+{
+	int_vector_free(&corners->vertex_index);
+	int_vector_free(&corners->texture_index);
+	int_vector_free(&corners->normal_index);
+}
+
+/* Every corner of a face line; returns the number of corners, which
+ * ends early only if out of memory */
+int obj_parse_corners(obj_line *line, obj_corners *corners)
+{
+	obj_token token;
+	int vertex, texture, normal;
+
+	corners->vertex_index.count = 0;
+	corners->texture_index.count = 0;
+	corners->normal_index.count = 0;
+
+	while( obj_line_next_token(line, &token) )
+	{
+		obj_scan_index(token.begin, token.begin + token.length, &vertex, &texture, &normal);
+
+		if(!int_vector_append(&corners->vertex_index, &vertex, 1) ||
+		   !int_vector_append(&corners->texture_index, &texture, 1) ||
+		   !int_vector_append(&corners->normal_index, &normal, 1))
+			break;
+	}
+
+	//all three lists end at the same corner
+	corners->texture_index.count = corners->vertex_index.count;
+	corners->normal_index.count = corners->vertex_index.count;
+	return corners->vertex_index.count;
+}
+
+/* Number of obj_faces a face line is stored as: one, or a fan of
+ * triangles if it has more corners than an obj_face holds */
+int obj_face_piece_count(const obj_corners *corners)
+{
+	int count = corners->vertex_index.count;
+	return count <= MAX_VERTEX_COUNT ? 1 : count - 2;
+}
+
+/* Corners of one piece with the indices as written in the file;
+ * triangle piece k uses the corners 0, k+1 and k+2 */
+void obj_face_piece(const obj_corners *corners, int piece, obj_face *face)
+{
+	int count = corners->vertex_index.count;
+	int i, corner;
+
+	face->vertex_count = count <= MAX_VERTEX_COUNT ? count : 3;
+	for(i=0; i<MAX_VERTEX_COUNT; i++)
+	{
+		if(i >= face->vertex_count)
+		{
+			face->vertex_index[i] = 0;
+			face->texture_index[i] = 0;
+			face->normal_index[i] = 0;
+			continue;
+		}
+
+		corner = i == 0 || count <= MAX_VERTEX_COUNT ? i : piece + i;
+		face->vertex_index[i] = corners->vertex_index.items[corner];
+		face->texture_index[i] = corners->texture_index.items[corner];
+		face->normal_index[i] = corners->normal_index.items[corner];
+	}
+}
+
+void obj_parse_face(obj_growable_scene_data *scene, obj_line *line, obj_corners *corners,
+                    obj_parse_chunk *chunk, int material_index)
+{
+	obj_face *face;
+	int relative_mask;
+	int piece, pieces;
+
+	obj_parse_corners(line, corners);
+	pieces = obj_face_piece_count(corners);
+
+	for(piece=0; piece<pieces; piece++)
+	{
+		face = obj_faces_push(&scene->face_list);
+		obj_face_piece(corners, piece, face);
+
+		relative_mask = obj_relative_index_mask(face);
+		obj_convert_to_list_index_v(scene->vertex_list.count, face->vertex_index);
+		obj_convert_to_list_index_v(scene->vertex_texture_list.count, face->texture_index);
+		obj_convert_to_list_index_v(scene->vertex_normal_list.count, face->normal_index);
+		face->material_index = material_index;
+
+		if(chunk != NULL && relative_mask != 0)
+			obj_add_relative_face(chunk, scene->face_list.count - 1, relative_mask);
+	}
+}
+
+obj_sphere* obj_parse_sphere(obj_growable_scene_data *scene, obj_line *line)
 {
 	int temp_indices[MAX_VERTEX_COUNT];
 
-	obj_sphere *obj = (obj_sphere*)malloc(sizeof(obj_sphere));
-	obj_parse_vertex_index(temp_indices, obj->texture_index, NULL);
-	obj_convert_to_list_index_v(scene->vertex_texture_list.item_count, obj->texture_index);
-	obj->pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, temp_indices[0]);
-	obj->up_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[1]);
-	obj->equator_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[2]);
+	obj_sphere *obj = (obj_sphere*)arena_alloc(&scene->storage, sizeof(obj_sphere));
+	obj_parse_vertex_index(line, temp_indices, obj->texture_index, NULL);
+	obj_convert_to_list_index_v(scene->vertex_texture_list.count, obj->texture_index);
+	obj->pos_index = obj_convert_to_list_index(scene->vertex_list.count, temp_indices[0]);
+	obj->up_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.count, temp_indices[1]);
+	obj->equator_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.count, temp_indices[2]);
 
 	return obj;
 }
 
-obj_plane* obj_parse_plane(obj_growable_scene_data *scene)
+obj_plane* obj_parse_plane(obj_growable_scene_data *scene, obj_line *line)
 {
 	int temp_indices[MAX_VERTEX_COUNT];
 
-	obj_plane *obj = (obj_plane*)malloc(sizeof(obj_plane));
-	obj_parse_vertex_index(temp_indices, obj->texture_index, NULL);
-	obj_convert_to_list_index_v(scene->vertex_texture_list.item_count, obj->texture_index);
-	obj->pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, temp_indices[0]);
-	obj->normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[1]);
-	obj->rotation_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[2]);
+	obj_plane *obj = (obj_plane*)arena_alloc(&scene->storage, sizeof(obj_plane));
+	obj_parse_vertex_index(line, temp_indices, obj->texture_index, NULL);
+	obj_convert_to_list_index_v(scene->vertex_texture_list.count, obj->texture_index);
+	obj->pos_index = obj_convert_to_list_index(scene->vertex_list.count, temp_indices[0]);
+	obj->normal_index = obj_convert_to_list_index(scene->vertex_normal_list.count, temp_indices[1]);
+	obj->rotation_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.count, temp_indices[2]);
 
 	return obj;
 }
 
-obj_light_point* obj_parse_light_point(obj_growable_scene_data *scene)
+obj_light_point* obj_parse_light_point(obj_growable_scene_data *scene, obj_line *line)
 {
-	obj_light_point *o= (obj_light_point*)malloc(sizeof(obj_light_point));
-	o->pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, atoi( strtok(NULL, WHITESPACE)) );
+	obj_token token;
+	obj_light_point *o= (obj_light_point*)arena_alloc(&scene->storage, sizeof(obj_light_point));
+	o->pos_index = -1;
+	if( obj_line_next_token(line, &token) )
+		o->pos_index = obj_convert_to_list_index(scene->vertex_list.count, obj_scan_int(token.begin, token.begin + token.length, NULL));
 	return o;
 }
 
-obj_light_quad* obj_parse_light_quad(obj_growable_scene_data *scene)
+obj_light_quad* obj_parse_light_quad(obj_growable_scene_data *scene, obj_line *line)
 {
-	obj_light_quad *o = (obj_light_quad*)malloc(sizeof(obj_light_quad));
-	obj_parse_vertex_index(o->vertex_index, NULL, NULL);
-	obj_convert_to_list_index_v(scene->vertex_list.item_count, o->vertex_index);
+	obj_light_quad *o = (obj_light_quad*)arena_alloc(&scene->storage, sizeof(obj_light_quad));
+	obj_parse_vertex_index(line, o->vertex_index, NULL, NULL);
+	obj_convert_to_list_index_v(scene->vertex_list.count, o->vertex_index);
 
 	return o;
 }
 
-obj_light_disc* obj_parse_light_disc(obj_growable_scene_data *scene)
+obj_light_disc* obj_parse_light_disc(obj_growable_scene_data *scene, obj_line *line)
 {
 	int temp_indices[MAX_VERTEX_COUNT];
 
-	obj_light_disc *obj = (obj_light_disc*)malloc(sizeof(obj_light_disc));
-	obj_parse_vertex_index(temp_indices, NULL, NULL);
-	obj->pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, temp_indices[0]);
-	obj->normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[1]);
+	obj_light_disc *obj = (obj_light_disc*)arena_alloc(&scene->storage, sizeof(obj_light_disc));
+	obj_parse_vertex_index(line, temp_indices, NULL, NULL);
+	obj->pos_index = obj_convert_to_list_index(scene->vertex_list.count, temp_indices[0]);
+	obj->normal_index = obj_convert_to_list_index(scene->vertex_normal_list.count, temp_indices[1]);
 
 	return obj;
 }
 
-obj_vector* obj_parse_vector()
+void obj_parse_vector_values(obj_line *line, obj_vector *v)
 {
-	obj_vector *v = (obj_vector*)malloc(sizeof(obj_vector));
-	v->e[0] = atof( strtok(NULL, WHITESPACE));
-	v->e[1] = atof( strtok(NULL, WHITESPACE));
-	v->e[2] = atof( strtok(NULL, WHITESPACE));
+	v->e[0] = obj_parse_double(line);
+	v->e[1] = obj_parse_double(line);
+	v->e[2] = obj_parse_double(line);
+}
+
+obj_vector* obj_parse_vector(obj_vectors *vectors, obj_line *line)
+{
+	obj_vector *v = obj_vectors_push(vectors);
+	obj_parse_vector_values(line, v);
 	return v;
 }
 
-void obj_parse_camera(obj_growable_scene_data *scene, obj_camera *camera)
+void obj_parse_camera(obj_growable_scene_data *scene, obj_line *line, obj_camera *camera)
 {
-	int indices[3];
-	obj_parse_vertex_index(indices, NULL, NULL);
-	camera->camera_pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, indices[0]);
-	camera->camera_look_point_index = obj_convert_to_list_index(scene->vertex_list.item_count, indices[1]);
-	camera->camera_up_norm_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, indices[2]);
+	int indices[MAX_VERTEX_COUNT];
+	obj_parse_vertex_index(line, indices, NULL, NULL);
+	camera->camera_pos_index = obj_convert_to_list_index(scene->vertex_list.count, indices[0]);
+	camera->camera_look_point_index = obj_convert_to_list_index(scene->vertex_list.count, indices[1]);
+	camera->camera_up_norm_index = obj_convert_to_list_index(scene->vertex_normal_list.count, indices[2]);
 }
 
-int obj_parse_mtl_file(char *filename, list *material_list)
+int obj_parse_mtl_file(char *filename, list *material_list, arena *storage)
 {
-	int line_number = 0;
-	char *current_token;
-	char current_line[OBJ_LINE_SIZE];
+	obj_reader mtl_reader;
+	obj_line current_line;
+	obj_token current_token;
+	obj_token name_token;
 	char material_open = 0;
 	obj_material *current_mtl = NULL;
-	FILE *mtl_file_stream;
 	
 	// open scene
-	mtl_file_stream = fopen( filename, "r");
-	if(mtl_file_stream == 0)
+	if( !obj_reader_open(&mtl_reader, filename) )
 	{
 		fprintf(stderr, "Error reading file: %s\n", filename);
 		return 0;
 	}
-		
-	list_make(material_list, 10, 1);
 
-	while( fgets(current_line, OBJ_LINE_SIZE, mtl_file_stream) )
+	while( obj_reader_next_line(&mtl_reader, &current_line) )
 	{
-		current_token = strtok( current_line, " \t\n\r");
-		line_number++;
-		
 		//skip comments
-		if( current_token == NULL || strequal(current_token, "//") || strequal(current_token, "#"))
+		if( !obj_line_next_token(&current_line, &current_token) || 
+		    obj_token_equal(&current_token, "//") || obj_token_equal(&current_token, "#"))
 			continue;
 		
 
 		//start material
-		else if( strequal(current_token, "newmtl"))
+		else if( obj_token_equal(&current_token, "newmtl"))
 		{
 			material_open = 1;
-			current_mtl = (obj_material*) malloc(sizeof(obj_material));
+			current_mtl = (obj_material*) arena_alloc(storage, sizeof(obj_material));
 			obj_set_material_defaults(current_mtl);
 			
 			// get the name
-			strncpy(current_mtl->name, strtok(NULL, " \t"), MATERIAL_NAME_SIZE);
+			current_mtl->name[0] = '\0';
+			if( obj_line_next_token(&current_line, &name_token) )
+				obj_token_copy(&name_token, current_mtl->name, MATERIAL_NAME_SIZE);
 			list_add_item(material_list, current_mtl, current_mtl->name);
 		}
 		
 		//ambient
-		else if( strequal(current_token, "Ka") && material_open)
+		else if( obj_token_equal(&current_token, "Ka") && material_open)
 		{
-			current_mtl->amb[0] = atof( strtok(NULL, " \t"));
-			current_mtl->amb[1] = atof( strtok(NULL, " \t"));
-			current_mtl->amb[2] = atof( strtok(NULL, " \t"));
+			current_mtl->amb[0] = obj_parse_double(&current_line);
+			current_mtl->amb[1] = obj_parse_double(&current_line);
+			current_mtl->amb[2] = obj_parse_double(&current_line);
 		}
 
 		//diff
-		else if( strequal(current_token, "Kd") && material_open)
+		else if( obj_token_equal(&current_token, "Kd") && material_open)
 		{
-			current_mtl->diff[0] = atof( strtok(NULL, " \t"));
-			current_mtl->diff[1] = atof( strtok(NULL, " \t"));
-			current_mtl->diff[2] = atof( strtok(NULL, " \t"));
+			current_mtl->diff[0] = obj_parse_double(&current_line);
+			current_mtl->diff[1] = obj_parse_double(&current_line);
+			current_mtl->diff[2] = obj_parse_double(&current_line);
 		}
 		
 		//specular
-		else if( strequal(current_token, "Ks") && material_open)
+		else if( obj_token_equal(&current_token, "Ks") && material_open)
 		{
-			current_mtl->spec[0] = atof( strtok(NULL, " \t"));
-			current_mtl->spec[1] = atof( strtok(NULL, " \t"));
-			current_mtl->spec[2] = atof( strtok(NULL, " \t"));
+			current_mtl->spec[0] = obj_parse_double(&current_line);
+			current_mtl->spec[1] = obj_parse_double(&current_line);
+			current_mtl->spec[2] = obj_parse_double(&current_line);
 		}
 		//shiny
-		else if( strequal(current_token, "Ns") && material_open)
+		else if( obj_token_equal(&current_token, "Ns") && material_open)
 		{
-			current_mtl->shiny = atof( strtok(NULL, " \t"));
+			current_mtl->shiny = obj_parse_double(&current_line);
 		}
 		//transparent
-		else if( strequal(current_token, "d") && material_open)
+		else if( obj_token_equal(&current_token, "d") && material_open)
 		{
-			current_mtl->trans = atof( strtok(NULL, " \t"));
+			current_mtl->trans = obj_parse_double(&current_line);
 		}
 		//reflection
-		else if( strequal(current_token, "r") && material_open)
+		else if( obj_token_equal(&current_token, "r") && material_open)
 		{
-			current_mtl->reflect = atof( strtok(NULL, " \t"));
+			current_mtl->reflect = obj_parse_double(&current_line);
 		}
 		//glossy
-		else if( strequal(current_token, "sharpness") && material_open)
+		else if( obj_token_equal(&current_token, "sharpness") && material_open)
 		{
-			current_mtl->glossy = atof( strtok(NULL, " \t"));
+			current_mtl->glossy = obj_parse_double(&current_line);
 		}
 		//refract index
-		else if( strequal(current_token, "Ni") && material_open)
+		else if( obj_token_equal(&current_token, "Ni") && material_open)
 		{
-			current_mtl->refract_index = atof( strtok(NULL, " \t"));
+			current_mtl->refract_index = obj_parse_double(&current_line);
 		}
 		// illumination type
-		else if( strequal(current_token, "illum") && material_open)
+		else if( obj_token_equal(&current_token, "illum") && material_open)
 		{
 		}
 		// texture map
-		else if( strequal(current_token, "map_Ka") && material_open)
+		else if( obj_token_equal(&current_token, "map_Ka") && material_open)
 		{
-			strncpy(current_mtl->texture_filename, strtok(NULL, " \t"), OBJ_FILENAME_LENGTH);
+			if( obj_line_next_token(&current_line, &name_token) )
+				obj_token_copy(&name_token, current_mtl->texture_filename, OBJ_FILENAME_LENGTH);
 		}
 		else
 		{
-			fprintf(stderr, "Unknown command '%s' in material file %s at line %i:\n\t%s\n",
-					current_token, filename, line_number, current_line);
+			fprintf(stderr, "Unknown command '%.*s' in material file %s at line %i:\n\t%.*s\n",
+					current_token.length, current_token.begin, filename, mtl_reader.line_number,
+					(int)(current_line.end - current_line.begin), current_line.begin);
 			//return 0;
 		}
 	}
 	
-	fclose(mtl_file_stream);
+	obj_reader_close(&mtl_reader);
 
 	return 1;
 
 }
 
+int obj_parse_obj_lines(obj_growable_scene_data *growable_data, obj_reader *obj_file_reader, obj_parse_chunk *chunk)
+{
+	int current_material = chunk != NULL ? OBJ_MATERIAL_INHERIT : -1; 
+	obj_corners corners;
+	obj_line current_line;
+	obj_token current_token;
+	obj_token name_token;
+	obj_keyword keyword;
+	char material_name[MATERIAL_NAME_SIZE];
+
+	obj_corners_make(&corners);
+
+	//parser loop
+	while( obj_reader_next_line(obj_file_reader, &current_line) )
+	{
+		//skip comments
+		if( !obj_line_next_token(&current_line, &current_token) || current_token.begin[0] == '#')
+			continue;
+
+		keyword = obj_scan_keyword(current_token.begin, current_token.length);
+
+		//parse objects
+		switch(keyword)
+		{
+			case OBJ_KEY_VERTEX: //process vertex
+				obj_parse_vector(&growable_data->vertex_list, &current_line);
+				break;
+
+			case OBJ_KEY_NORMAL: //process vertex normal
+				obj_parse_vector(&growable_data->vertex_normal_list, &current_line);
+				break;
+
+			case OBJ_KEY_TEXTURE: //process vertex texture
+				obj_parse_vector(&growable_data->vertex_texture_list, &current_line);
+				break;
+
+			case OBJ_KEY_FACE: //process face
+				obj_parse_face(growable_data, &current_line, &corners, chunk, current_material);
+				break;
+
+			case OBJ_KEY_SPHERE: //process sphere
+			{
+				if(chunk != NULL)
+					chunk->unsupported = 1;
+				obj_sphere *sphr = obj_parse_sphere(growable_data, &current_line);
+				sphr->material_index = current_material;
+				list_add_item(&growable_data->sphere_list, sphr, NULL);
+				break;
+			}
+
+			case OBJ_KEY_PLANE: //process plane
+			{
+				if(chunk != NULL)
+					chunk->unsupported = 1;
+				obj_plane *pl = obj_parse_plane(growable_data, &current_line);
+				pl->material_index = current_material;
+				list_add_item(&growable_data->plane_list, pl, NULL);
+				break;
+			}
+
+			case OBJ_KEY_POINT: //process point
+				//make a small sphere to represent the point?
+				break;
+
+			case OBJ_KEY_LIGHT_POINT: //light point source
+			{
+				if(chunk != NULL)
+					chunk->unsupported = 1;
+				obj_light_point *o = obj_parse_light_point(growable_data, &current_line);
+				o->material_index = current_material;
+				list_add_item(&growable_data->light_point_list, o, NULL);
+				break;
+			}
+
+			case OBJ_KEY_LIGHT_DISC: //process light disc
+			{
+				if(chunk != NULL)
+					chunk->unsupported = 1;
+				obj_light_disc *o = obj_parse_light_disc(growable_data, &current_line);
+				o->material_index = current_material;
+				list_add_item(&growable_data->light_disc_list, o, NULL);
+				break;
+			}
+
+			case OBJ_KEY_LIGHT_QUAD: //process light quad
+			{
+				if(chunk != NULL)
+					chunk->unsupported = 1;
+				obj_light_quad *o = obj_parse_light_quad(growable_data, &current_line);
+				o->material_index = current_material;
+				list_add_item(&growable_data->light_quad_list, o, NULL);
+				break;
+			}
+
+			case OBJ_KEY_CAMERA: //camera
+				if(chunk != NULL)
+					chunk->unsupported = 1;
+				growable_data->camera = (obj_camera*) arena_alloc(&growable_data->storage, sizeof(obj_camera));
+				obj_parse_camera(growable_data, &current_line, growable_data->camera);
+				break;
+
+			case OBJ_KEY_USEMTL: // usemtl
+				current_material = -1;
+				if( obj_line_next_token(&current_line, &name_token) )
+				{
+					obj_token_copy(&name_token, material_name, MATERIAL_NAME_SIZE);
+					//chunks only record the name, materials are resolved after merging
+					if(chunk != NULL)
+						current_material = name_pool_add(&chunk->material_names, material_name);
+					else
+						current_material = list_find(&growable_data->material_list, material_name);
+				}
+				if(chunk != NULL)
+					chunk->has_usemtl = 1;
+				break;
+
+			case OBJ_KEY_MTLLIB: // mtllib
+				if( obj_line_next_token(&current_line, &name_token) )
+				{
+					obj_token_copy(&name_token, growable_data->material_filename, OBJ_FILENAME_LENGTH);
+					if(chunk != NULL)
+					{
+						chunk->mtllib_count++;
+						if(chunk->has_usemtl)
+							chunk->usemtl_before_mtllib = 1;
+					}
+					else
+						obj_parse_mtl_file(growable_data->material_filename, &growable_data->material_list, &growable_data->storage);
+				}
+				break;
+
+			case OBJ_KEY_OBJECT: //object name
+			case OBJ_KEY_SMOOTHING: //smoothing
+			case OBJ_KEY_GROUP: // group
+				break;
+
+			default:
+				printf("Unknown command '%.*s' in scene code at line %i: \"%.*s\".\n",
+						current_token.length, current_token.begin, obj_file_reader->line_number,
+						(int)(current_line.end - current_line.begin), current_line.begin);
+				break;
+		}
+	}
+
+	if(chunk != NULL)
+		chunk->final_material = current_material;
+
+	obj_corners_free(&corners);
+	return 1;
+}
+
 int obj_parse_obj_file(obj_growable_scene_data *growable_data, char *filename)
 {
+	obj_reader obj_file_reader;
 
-	FILE* obj_file_stream;
-	int current_material = -1; 
-	char *current_token = NULL;
-	char current_line[OBJ_LINE_SIZE];
-	int line_number = 0;
 	// open scene
-	obj_file_stream = fopen( filename, "r");
-	if(obj_file_stream == 0)
+	if( !obj_reader_open(&obj_file_reader, filename) )
 	{
 		fprintf(stderr, "Error reading file: %s\n", filename);
 		return 0;
@@ -337,113 +649,9 @@ int obj_parse_obj_file(obj_growable_scene_data *growable_data, char *filename)
 			if(v->z < extreme_dimensions[0].z) extreme_dimensions[0].z = v->z;
 			if(v->z > extreme_dimensions[1].z) extreme_dimensions[1].z = v->z;*/
 
+	obj_parse_obj_lines(growable_data, &obj_file_reader, NULL);
 
-	//parser loop
-	while( fgets(current_line, OBJ_LINE_SIZE, obj_file_stream) )
-	{
-		current_token = strtok( current_line, " \t\n\r");
-		line_number++;
-		
-		//skip comments
-		if( current_token == NULL || current_token[0] == '#')
-			continue;
-
-		//parse objects
-		else if( strequal(current_token, "v") ) //process vertex
-		{
-			list_add_item(&growable_data->vertex_list,  obj_parse_vector(), NULL);
-		}
-		
-		else if( strequal(current_token, "vn") ) //process vertex normal
-		{
-			list_add_item(&growable_data->vertex_normal_list,  obj_parse_vector(), NULL);
-		}
-		
-		else if( strequal(current_token, "vt") ) //process vertex texture
-		{
-			list_add_item(&growable_data->vertex_texture_list,  obj_parse_vector(), NULL);
-		}
-		
-		else if( strequal(current_token, "f") ) //process face
-		{
-			obj_face *face = obj_parse_face(growable_data);
-			face->material_index = current_material;
-			list_add_item(&growable_data->face_list, face, NULL);
-		}
-		
-		else if( strequal(current_token, "sp") ) //process sphere
-		{
-			obj_sphere *sphr = obj_parse_sphere(growable_data);
-			sphr->material_index = current_material;
-			list_add_item(&growable_data->sphere_list, sphr, NULL);
-		}
-		
-		else if( strequal(current_token, "pl") ) //process plane
-		{
-			obj_plane *pl = obj_parse_plane(growable_data);
-			pl->material_index = current_material;
-			list_add_item(&growable_data->plane_list, pl, NULL);
-		}
-		
-		else if( strequal(current_token, "p") ) //process point
-		{
-			//make a small sphere to represent the point?
-		}
-		
-		else if( strequal(current_token, "lp") ) //light point source
-		{
-			obj_light_point *o = obj_parse_light_point(growable_data);
-			o->material_index = current_material;
-			list_add_item(&growable_data->light_point_list, o, NULL);
-		}
-		
-		else if( strequal(current_token, "ld") ) //process light disc
-		{
-			obj_light_disc *o = obj_parse_light_disc(growable_data);
-			o->material_index = current_material;
-			list_add_item(&growable_data->light_disc_list, o, NULL);
-		}
-		
-		else if( strequal(current_token, "lq") ) //process light quad
-		{
-			obj_light_quad *o = obj_parse_light_quad(growable_data);
-			o->material_index = current_material;
-			list_add_item(&growable_data->light_quad_list, o, NULL);
-		}
-		
-		else if( strequal(current_token, "c") ) //camera
-		{
-			growable_data->camera = (obj_camera*) malloc(sizeof(obj_camera));
-			obj_parse_camera(growable_data, growable_data->camera);
-		}
-		
-		else if( strequal(current_token, "usemtl") ) // usemtl
-		{
-			current_material = list_find(&growable_data->material_list, strtok(NULL, WHITESPACE));
-		}
-		
-		else if( strequal(current_token, "mtllib") ) // mtllib
-		{
-			strncpy(growable_data->material_filename, strtok(NULL, WHITESPACE), OBJ_FILENAME_LENGTH);
-			obj_parse_mtl_file(growable_data->material_filename, &growable_data->material_list);
-			continue;
-		}
-		
-		else if( strequal(current_token, "o") ) //object name
-		{ }
-		else if( strequal(current_token, "s") ) //smoothing
-		{ }
-		else if( strequal(current_token, "g") ) // group
-		{ }		
-
-		else
-		{
-			printf("Unknown command '%s' in scene code at line %i: \"%s\".\n",
-					current_token, line_number, current_line);
-		}
-	}
-
-	fclose(obj_file_stream);
+	obj_reader_close(&obj_file_reader);
 	
 	return 1;
 }
@@ -451,11 +659,11 @@ int obj_parse_obj_file(obj_growable_scene_data *growable_data, char *filename)
 
 void obj_init_temp_storage(obj_growable_scene_data *growable_data)
 {
-	list_make(&growable_data->vertex_list, 10, 1);
-	list_make(&growable_data->vertex_normal_list, 10, 1);
-	list_make(&growable_data->vertex_texture_list, 10, 1);
+	obj_vectors_make(&growable_data->vertex_list, 0);
+	obj_vectors_make(&growable_data->vertex_normal_list, 0);
+	obj_vectors_make(&growable_data->vertex_texture_list, 0);
 	
-	list_make(&growable_data->face_list, 10, 1);
+	obj_faces_make(&growable_data->face_list, 0);
 	list_make(&growable_data->sphere_list, 10, 1);
 	list_make(&growable_data->plane_list, 10, 1);
 	
@@ -464,17 +672,14 @@ void obj_init_temp_storage(obj_growable_scene_data *growable_data)
 	list_make(&growable_data->light_disc_list, 10, 1);
 	
 	list_make(&growable_data->material_list, 10, 1);	
+	list_index_names(&growable_data->material_list);
 	
+	arena_make(&growable_data->storage, ARENA_MIN_CHUNK_SIZE);
 	growable_data->camera = NULL;
 }
 
 void obj_free_temp_storage(obj_growable_scene_data *growable_data)
 {
-	obj_free_half_list(&growable_data->vertex_list);
-	obj_free_half_list(&growable_data->vertex_normal_list);
-	obj_free_half_list(&growable_data->vertex_texture_list);
-	
-	obj_free_half_list(&growable_data->face_list);
 	obj_free_half_list(&growable_data->sphere_list);
 	obj_free_half_list(&growable_data->plane_list);
 	
@@ -485,54 +690,67 @@ void obj_free_temp_storage(obj_growable_scene_data *growable_data)
 	obj_free_half_list(&growable_data->material_list);
 }
 
-void delete_obj_data(obj_scene_data *data_out)
+void obj_free_item_arrays(obj_growable_scene_data *growable_data)
 {
-	int i;
+	obj_vectors_free(&growable_data->vertex_list);
+	obj_vectors_free(&growable_data->vertex_normal_list);
+	obj_vectors_free(&growable_data->vertex_texture_list);
 	
-	for(i=0; i<data_out->vertex_count; i++)
-		free(data_out->vertex_list[i]);
+	obj_faces_free(&growable_data->face_list);
+	free(growable_data->sphere_list.items);
+	free(growable_data->plane_list.items);
+	
+	free(growable_data->light_point_list.items);
+	free(growable_data->light_quad_list.items);
+	free(growable_data->light_disc_list.items);
+	
+	free(growable_data->material_list.items);
+}
+
+void delete_obj_data(obj_scene_data *data_out)
+{
+	//vertices and faces are stored inline, all else lives in the scene arena
+	free(data_out->vertex_storage);
+	free(data_out->vertex_normal_storage);
+	free(data_out->vertex_texture_storage);
+	free(data_out->face_storage);
+
 	free(data_out->vertex_list);
-	for(i=0; i<data_out->vertex_normal_count; i++)
-		free(data_out->vertex_normal_list[i]);
 	free(data_out->vertex_normal_list);
-	for(i=0; i<data_out->vertex_texture_count; i++)
-		free(data_out->vertex_texture_list[i]);
 	free(data_out->vertex_texture_list);
 
-	for(i=0; i<data_out->face_count; i++)
-		free(data_out->face_list[i]);
 	free(data_out->face_list);
-	for(i=0; i<data_out->sphere_count; i++)
-		free(data_out->sphere_list[i]);
 	free(data_out->sphere_list);
-	for(i=0; i<data_out->plane_count; i++)
-		free(data_out->plane_list[i]);
 	free(data_out->plane_list);
 
-	for(i=0; i<data_out->light_point_count; i++)
-		free(data_out->light_point_list[i]);
 	free(data_out->light_point_list);
-	for(i=0; i<data_out->light_disc_count; i++)
-		free(data_out->light_disc_list[i]);
 	free(data_out->light_disc_list);
-	for(i=0; i<data_out->light_quad_count; i++)
-		free(data_out->light_quad_list[i]);
 	free(data_out->light_quad_list);
 
-	for(i=0; i<data_out->material_count; i++)
-		free(data_out->material_list[i]);
 	free(data_out->material_list);
 
-	free(data_out->camera);
+	arena_free(&data_out->storage);
+}
+
+obj_vector** obj_vector_pointers(obj_vectors *vectors)
+{
+	obj_vector **pointers = (obj_vector**) malloc(sizeof(obj_vector*) * vectors->count + 1);
+	int i;
+
+	for(i=0; i<vectors->count; i++)
+		pointers[i] = &vectors->items[i];
+	return pointers;
 }
 
 void obj_copy_to_out_storage(obj_scene_data *data_out, obj_growable_scene_data *growable_data)
 {
-	data_out->vertex_count = growable_data->vertex_list.item_count;
-	data_out->vertex_normal_count = growable_data->vertex_normal_list.item_count;
-	data_out->vertex_texture_count = growable_data->vertex_texture_list.item_count;
+	int i;
 
-	data_out->face_count = growable_data->face_list.item_count;
+	data_out->vertex_count = growable_data->vertex_list.count;
+	data_out->vertex_normal_count = growable_data->vertex_normal_list.count;
+	data_out->vertex_texture_count = growable_data->vertex_texture_list.count;
+
+	data_out->face_count = growable_data->face_list.count;
 	data_out->sphere_count = growable_data->sphere_list.item_count;
 	data_out->plane_count = growable_data->plane_list.item_count;
 
@@ -542,11 +760,19 @@ void obj_copy_to_out_storage(obj_scene_data *data_out, obj_growable_scene_data *
 
 	data_out->material_count = growable_data->material_list.item_count;
 	
-	data_out->vertex_list = (obj_vector**)growable_data->vertex_list.items;
-	data_out->vertex_normal_list = (obj_vector**)growable_data->vertex_normal_list.items;
-	data_out->vertex_texture_list = (obj_vector**)growable_data->vertex_texture_list.items;
+	//the public lists are arrays of pointers into the inline storage
+	data_out->vertex_list = obj_vector_pointers(&growable_data->vertex_list);
+	data_out->vertex_normal_list = obj_vector_pointers(&growable_data->vertex_normal_list);
+	data_out->vertex_texture_list = obj_vector_pointers(&growable_data->vertex_texture_list);
+
+	data_out->face_list = (obj_face**) malloc(sizeof(obj_face*) * data_out->face_count + 1);
+	for(i=0; i<data_out->face_count; i++)
+		data_out->face_list[i] = &growable_data->face_list.items[i];
 
-	data_out->face_list = (obj_face**)growable_data->face_list.items;
+	data_out->vertex_storage = growable_data->vertex_list.items;
+	data_out->vertex_normal_storage = growable_data->vertex_normal_list.items;
+	data_out->vertex_texture_storage = growable_data->vertex_texture_list.items;
+	data_out->face_storage = growable_data->face_list.items;
 	data_out->sphere_list = (obj_sphere**)growable_data->sphere_list.items;
 	data_out->plane_list = (obj_plane**)growable_data->plane_list.items;
 
@@ -557,6 +783,7 @@ void obj_copy_to_out_storage(obj_scene_data *data_out, obj_growable_scene_data *
 	data_out->material_list = (obj_material**)growable_data->material_list.items;
 	
 	data_out->camera = growable_data->camera;
+	data_out->storage = growable_data->storage;
 }
 
 int parse_obj_scene(obj_scene_data *data_out, char *filename)
@@ -565,10 +792,490 @@ int parse_obj_scene(obj_scene_data *data_out, char *filename)
 
 	obj_init_temp_storage(&growable_data);
 	if( obj_parse_obj_file(&growable_data, filename) == 0)
+	{
+		obj_free_temp_storage(&growable_data);
+		obj_free_item_arrays(&growable_data);
+		arena_free(&growable_data.storage);
 		return 0;
+	}
 	
 	obj_copy_to_out_storage(data_out, &growable_data);
 	obj_free_temp_storage(&growable_data);
 	return 1;
 }
 
+void obj_parse_chunk_job(void *argument)
+{
+	obj_parse_chunk *chunk = (obj_parse_chunk*) argument;
+	obj_parse_obj_lines(&chunk->scene, &chunk->reader, chunk);
+}
+
+void obj_fix_chunk_job(void *argument)
+{
+	obj_parse_chunk *chunk = (obj_parse_chunk*) argument;
+	obj_relative_face *relative;
+	obj_face *face;
+	int i, j;
+
+	for(i=0; i<chunk->scene.face_list.count; i++)
+	{
+		face = &chunk->scene.face_list.items[i];
+		if(face->material_index == OBJ_MATERIAL_INHERIT)
+			face->material_index = chunk->inherited_material;
+		else if(face->material_index >= 0)
+			face->material_index = chunk->material_remap[face->material_index];
+	}
+
+	//negative indices were resolved against chunk local counts
+	for(i=0; i<chunk->relative_faces.count; i++)
+	{
+		relative = &chunk->relative_faces.items[i];
+		face = &chunk->scene.face_list.items[relative->face];
+		for(j=0; j<MAX_VERTEX_COUNT; j++)
+		{
+			if(relative->mask & (OBJ_RELATIVE_VERTEX << j))
+				face->vertex_index[j] += chunk->vertex_offset;
+			if(relative->mask & (OBJ_RELATIVE_TEXTURE << j))
+				face->texture_index[j] += chunk->texture_offset;
+			if(relative->mask & (OBJ_RELATIVE_NORMAL << j))
+				face->normal_index[j] += chunk->normal_offset;
+		}
+	}
+}
+
+void obj_free_chunk(obj_parse_chunk *chunk)
+{
+	obj_free_temp_storage(&chunk->scene);
+	obj_free_item_arrays(&chunk->scene);
+	arena_free(&chunk->scene.storage);
+	name_pool_free(&chunk->material_names);
+	obj_relative_faces_free(&chunk->relative_faces);
+	free(chunk->material_remap);
+}
+
+int parse_obj_scene_parallel(obj_scene_data *data_out, char *filename, int thread_count)
+{
+	obj_growable_scene_data growable_data;
+	obj_reader reader;
+	obj_parse_chunk *chunks;
+	obj_parse_chunk *chunk;
+	thread_pool pool;
+	const char *chunk_begin, *chunk_end, *file_end;
+	int chunk_count, i, j;
+	int face_count = 0;
+	int current_material = -1;
+	char fallback = 0;
+	char material_state_seen = 0;
+
+	if(thread_count <= 0)
+		thread_count = thread_pool_default_size();
+
+	if( !obj_reader_open(&reader, filename) )
+	{
+		fprintf(stderr, "Error reading file: %s\n", filename);
+		return 0;
+	}
+
+	chunk_count = thread_count * OBJ_PARALLEL_CHUNKS_PER_THREAD;
+	if(reader.size / chunk_count < OBJ_PARALLEL_MIN_CHUNK_SIZE)
+		chunk_count = (int)(reader.size / OBJ_PARALLEL_MIN_CHUNK_SIZE);
+
+	if(thread_count < 2 || chunk_count < 2 || !thread_pool_make(&pool, thread_count))
+	{
+		obj_reader_close(&reader);
+		return parse_obj_scene(data_out, filename);
+	}
+
+	//split into chunks ending right after a newline
+	chunks = (obj_parse_chunk*) calloc(chunk_count, sizeof(obj_parse_chunk));
+	if(chunks == NULL)
+	{
+		thread_pool_free(&pool);
+		obj_reader_close(&reader);
+		return parse_obj_scene(data_out, filename);
+	}
+	file_end = reader.data + reader.size;
+	chunk_begin = reader.data;
+	for(i=0; i<chunk_count; i++)
+	{
+		chunk = &chunks[i];
+		chunk_end = file_end;
+		if(i < chunk_count-1)
+		{
+			chunk_end = reader.data + reader.size/chunk_count*(i+1);
+			if(chunk_end < chunk_begin)
+				chunk_end = chunk_begin;
+			chunk_end = obj_scan_newline(chunk_end, file_end);
+			if(chunk_end < file_end)
+				chunk_end++;
+		}
+
+		chunk->reader.data = chunk_begin;
+		chunk->reader.size = chunk_end - chunk_begin;
+		chunk->reader.map_size = 0;
+		chunk->reader.cursor = chunk_begin;
+		chunk->reader.line_number = 0;
+		chunk_begin = chunk_end;
+
+		obj_init_temp_storage(&chunk->scene);
+		name_pool_make(&chunk->material_names);
+		obj_relative_faces_make(&chunk->relative_faces, 0);
+
+		//a chunk that cannot be queued is parsed right here
+		if(!thread_pool_submit(&pool, obj_parse_chunk_job, chunk))
+			obj_parse_chunk_job(chunk);
+	}
+	thread_pool_wait(&pool);
+
+	//only geometry, usemtl and a single leading mtllib are handled in parallel
+	for(i=0; i<chunk_count; i++)
+	{
+		chunk = &chunks[i];
+		if(chunk->unsupported || chunk->usemtl_before_mtllib || chunk->mtllib_count > 1 ||
+		   (chunk->mtllib_count > 0 && material_state_seen))
+			fallback = 1;
+		if(chunk->mtllib_count > 0 || chunk->has_usemtl)
+			material_state_seen = 1;
+	}
+
+	if(fallback)
+	{
+		thread_pool_free(&pool);
+		for(i=0; i<chunk_count; i++)
+			obj_free_chunk(&chunks[i]);
+		free(chunks);
+		obj_reader_close(&reader);
+		return parse_obj_scene(data_out, filename);
+	}
+
+	obj_init_temp_storage(&growable_data);
+	for(i=0; i<chunk_count; i++)
+	{
+		if(chunks[i].mtllib_count > 0)
+		{
+			strcpy(growable_data.material_filename, chunks[i].scene.material_filename);
+			obj_parse_mtl_file(growable_data.material_filename, &growable_data.material_list, &growable_data.storage);
+		}
+	}
+
+	//prefix pass: global offsets and the material active at each chunk start
+	for(i=0; i<chunk_count; i++)
+	{
+		chunk = &chunks[i];
+		if(i == 0)
+		{
+			chunk->vertex_offset = 0;
+			chunk->texture_offset = 0;
+			chunk->normal_offset = 0;
+		}
+		else
+		{
+			chunk->vertex_offset = chunks[i-1].vertex_offset + chunks[i-1].scene.vertex_list.count;
+			chunk->texture_offset = chunks[i-1].texture_offset + chunks[i-1].scene.vertex_texture_list.count;
+			chunk->normal_offset = chunks[i-1].normal_offset + chunks[i-1].scene.vertex_normal_list.count;
+		}
+
+		chunk->material_remap = (int*) malloc(sizeof(int) * (chunk->material_names.offsets.count + 1));
+		for(j=0; j<chunk->material_names.offsets.count; j++)
+			chunk->material_remap[j] = list_find(&growable_data.material_list, (char*)name_pool_get(&chunk->material_names, j));
+
+		chunk->inherited_material = current_material;
+		if(chunk->final_material >= 0)
+			current_material = chunk->material_remap[chunk->final_material];
+		else if(chunk->final_material == -1)
+			current_material = -1;
+
+		if(!thread_pool_submit(&pool, obj_fix_chunk_job, chunk))
+			obj_fix_chunk_job(chunk);
+	}
+	thread_pool_wait(&pool);
+	thread_pool_free(&pool);
+
+	//concatenate the chunk arrays, sized once from the final offsets
+	chunk = &chunks[chunk_count-1];
+	obj_vectors_reserve(&growable_data.vertex_list, chunk->vertex_offset + chunk->scene.vertex_list.count);
+	obj_vectors_reserve(&growable_data.vertex_normal_list, chunk->normal_offset + chunk->scene.vertex_normal_list.count);
+	obj_vectors_reserve(&growable_data.vertex_texture_list, chunk->texture_offset + chunk->scene.vertex_texture_list.count);
+	for(i=0; i<chunk_count; i++)
+		face_count += chunks[i].scene.face_list.count;
+	obj_faces_reserve(&growable_data.face_list, face_count);
+
+	for(i=0; i<chunk_count; i++)
+	{
+		chunk = &chunks[i];
+		obj_vectors_append(&growable_data.vertex_list, chunk->scene.vertex_list.items, chunk->scene.vertex_list.count);
+		obj_vectors_append(&growable_data.vertex_normal_list, chunk->scene.vertex_normal_list.items, chunk->scene.vertex_normal_list.count);
+		obj_vectors_append(&growable_data.vertex_texture_list, chunk->scene.vertex_texture_list.items, chunk->scene.vertex_texture_list.count);
+		obj_faces_append(&growable_data.face_list, chunk->scene.face_list.items, chunk->scene.face_list.count);
+
+		arena_adopt(&growable_data.storage, &chunks[i].scene.storage);
+		obj_free_chunk(&chunks[i]);
+	}
+	free(chunks);
+	obj_reader_close(&reader);
+
+	obj_copy_to_out_storage(data_out, &growable_data);
+	obj_free_temp_storage(&growable_data);
+	return 1;
+}
+
+int parse_obj_stream(char *filename, const obj_stream_callbacks *callbacks, void *context)
+{
+	obj_reader reader;
+	obj_line current_line;
+	obj_token current_token;
+	obj_token name_token;
+	obj_vector vector;
+	obj_face face;
+	obj_polygon polygon;
+	obj_corners corners;
+	list material_list;
+	arena storage;
+	char material_name[MATERIAL_NAME_SIZE];
+	char material_filename[OBJ_FILENAME_LENGTH];
+	int vertex_count = 0;
+	int normal_count = 0;
+	int texture_count = 0;
+	int current_material = -1;
+	int i, pieces, material_count;
+
+	if( !obj_reader_open(&reader, filename) )
+	{
+		fprintf(stderr, "Error reading file: %s\n", filename);
+		return 0;
+	}
+
+	//only materials are kept, geometry goes straight to the callbacks
+	list_make(&material_list, 10, 1);
+	list_index_names(&material_list);
+	arena_make(&storage, 0);
+	obj_corners_make(&corners);
+
+	while( obj_reader_next_line(&reader, &current_line) )
+	{
+		//skip comments
+		if( !obj_line_next_token(&current_line, &current_token) || current_token.begin[0] == '#')
+			continue;
+
+		switch( obj_scan_keyword(current_token.begin, current_token.length) )
+		{
+			case OBJ_KEY_VERTEX: //process vertex
+				obj_parse_vector_values(&current_line, &vector);
+				if(callbacks->vertex != NULL)
+					callbacks->vertex(context, &vector);
+				vertex_count++;
+				break;
+
+			case OBJ_KEY_NORMAL: //process vertex normal
+				obj_parse_vector_values(&current_line, &vector);
+				if(callbacks->vertex_normal != NULL)
+					callbacks->vertex_normal(context, &vector);
+				normal_count++;
+				break;
+
+			case OBJ_KEY_TEXTURE: //process vertex texture
+				obj_parse_vector_values(&current_line, &vector);
+				if(callbacks->vertex_texture != NULL)
+					callbacks->vertex_texture(context, &vector);
+				texture_count++;
+				break;
+
+			case OBJ_KEY_FACE: //process face
+				obj_parse_corners(&current_line, &corners);
+				pieces = obj_face_piece_count(&corners);
+
+				for(i=0; i<pieces && callbacks->face != NULL; i++)
+				{
+					obj_face_piece(&corners, i, &face);
+					obj_convert_to_list_index_v(vertex_count, face.vertex_index);
+					obj_convert_to_list_index_v(texture_count, face.texture_index);
+					obj_convert_to_list_index_v(normal_count, face.normal_index);
+					face.material_index = current_material;
+					callbacks->face(context, &face);
+				}
+
+				if(callbacks->polygon != NULL)
+				{
+					for(i=0; i<corners.vertex_index.count; i++)
+					{
+						corners.vertex_index.items[i] = obj_convert_to_list_index(vertex_count, corners.vertex_index.items[i]);
+						corners.texture_index.items[i] = obj_convert_to_list_index(texture_count, corners.texture_index.items[i]);
+						corners.normal_index.items[i] = obj_convert_to_list_index(normal_count, corners.normal_index.items[i]);
+					}
+
+					polygon.vertex_index = corners.vertex_index.items;
+					polygon.normal_index = corners.normal_index.items;
+					polygon.texture_index = corners.texture_index.items;
+					polygon.vertex_count = corners.vertex_index.count;
+					polygon.material_index = current_material;
+					callbacks->polygon(context, &polygon);
+				}
+				break;
+
+			case OBJ_KEY_USEMTL: // usemtl
+				current_material = -1;
+				if( obj_line_next_token(&current_line, &name_token) )
+				{
+					obj_token_copy(&name_token, material_name, MATERIAL_NAME_SIZE);
+					current_material = list_find(&material_list, material_name);
+				}
+				break;
+
+			case OBJ_KEY_MTLLIB: // mtllib
+				if( obj_line_next_token(&current_line, &name_token) )
+				{
+					material_count = material_list.item_count;
+					obj_token_copy(&name_token, material_filename, OBJ_FILENAME_LENGTH);
+					obj_parse_mtl_file(material_filename, &material_list, &storage);
+
+					for(i=material_count; i<material_list.item_count && callbacks->material != NULL; i++)
+						callbacks->material(context, (obj_material*)material_list.items[i]);
+				}
+				break;
+
+			default: //other primitives are not streamed
+				break;
+		}
+	}
+
+	obj_reader_close(&reader);
+	list_free(&material_list);
+	arena_free(&storage);
+	obj_corners_free(&corners);
+
+	return 1;
+}
+
+VECTOR_DECLARE(obj_reals, obj_real)
+VECTOR_DECLARE(obj_materials, obj_material)
+
+/* Arrays of a flat scene while it is filled by the stream callbacks */
+typedef struct
+{
+	obj_reals vertices;
+	obj_reals vertex_normals;
+	obj_reals vertex_textures;
+
+	int_vector face_start;
+	int_vector face_vertex_index;
+	int_vector face_normal_index;
+	int_vector face_texture_index;
+	int_vector face_material_index;
+
+	obj_materials materials;
+	char failed;
+} obj_flat_builder;
+
+void obj_flat_add_vector(obj_flat_builder *builder, obj_reals *reals, const obj_vector *v)
+{
+	obj_real e[3];
+
+	e[0] = (obj_real)v->e[0];
+	e[1] = (obj_real)v->e[1];
+	e[2] = (obj_real)v->e[2];
+
+	if(!obj_reals_append(reals, e, 3))
+		builder->failed = 1;
+}
+
+void obj_flat_vertex(void *context, const obj_vector *vertex)
+{
+	obj_flat_builder *builder = (obj_flat_builder*) context;
+	obj_flat_add_vector(builder, &builder->vertices, vertex);
+}
+
+void obj_flat_vertex_normal(void *context, const obj_vector *normal)
+{
+	obj_flat_builder *builder = (obj_flat_builder*) context;
+	obj_flat_add_vector(builder, &builder->vertex_normals, normal);
+}
+
+void obj_flat_vertex_texture(void *context, const obj_vector *texture)
+{
+	obj_flat_builder *builder = (obj_flat_builder*) context;
+	obj_flat_add_vector(builder, &builder->vertex_textures, texture);
+}
+
+void obj_flat_polygon(void *context, const obj_polygon *polygon)
+{
+	obj_flat_builder *builder = (obj_flat_builder*) context;
+	int corner = builder->face_vertex_index.count;
+
+	if(!int_vector_append(&builder->face_start, &corner, 1) ||
+	   !int_vector_append(&builder->face_material_index, &polygon->material_index, 1) ||
+	   !int_vector_append(&builder->face_vertex_index, polygon->vertex_index, polygon->vertex_count) ||
+	   !int_vector_append(&builder->face_normal_index, polygon->normal_index, polygon->vertex_count) ||
+	   !int_vector_append(&builder->face_texture_index, polygon->texture_index, polygon->vertex_count))
+		builder->failed = 1;
+}
+
+void obj_flat_material(void *context, const obj_material *material)
+{
+	obj_flat_builder *builder = (obj_flat_builder*) context;
+
+	if(!obj_materials_append(&builder->materials, material, 1))
+		builder->failed = 1;
+}
+
+int parse_obj_scene_flat(obj_flat_scene_data *data_out, char *filename)
+{
+	obj_flat_builder builder;
+	obj_stream_callbacks callbacks;
+	int corner;
+
+	memset(&builder, 0, sizeof(obj_flat_builder));
+
+	callbacks.vertex = obj_flat_vertex;
+	callbacks.vertex_normal = obj_flat_vertex_normal;
+	callbacks.vertex_texture = obj_flat_vertex_texture;
+	callbacks.face = NULL;
+	callbacks.polygon = obj_flat_polygon;
+	callbacks.material = obj_flat_material;
+
+	if( !parse_obj_stream(filename, &callbacks, &builder) )
+		builder.failed = 1;
+
+	//closing entry, face i uses corners face_start[i] .. face_start[i+1]-1
+	corner = builder.face_vertex_index.count;
+	if( !int_vector_append(&builder.face_start, &corner, 1) )
+		builder.failed = 1;
+
+	data_out->vertices = builder.vertices.items;
+	data_out->vertex_normals = builder.vertex_normals.items;
+	data_out->vertex_textures = builder.vertex_textures.items;
+	data_out->face_start = builder.face_start.items;
+	data_out->face_vertex_index = builder.face_vertex_index.items;
+	data_out->face_normal_index = builder.face_normal_index.items;
+	data_out->face_texture_index = builder.face_texture_index.items;
+	data_out->face_material_index = builder.face_material_index.items;
+	data_out->materials = builder.materials.items;
+
+	data_out->vertex_count = builder.vertices.count / 3;
+	data_out->vertex_normal_count = builder.vertex_normals.count / 3;
+	data_out->vertex_texture_count = builder.vertex_textures.count / 3;
+	data_out->face_count = builder.face_material_index.count;
+	data_out->face_corner_count = builder.face_vertex_index.count;
+	data_out->material_count = builder.materials.count;
+
+	if(builder.failed)
+	{
+		delete_obj_flat_data(data_out);
+		return 0;
+	}
+
+	return 1;
+}
+
+void delete_obj_flat_data(obj_flat_scene_data *data_out)
+{
+	free(data_out->vertices);
+	free(data_out->vertex_normals);
+	free(data_out->vertex_textures);
+	free(data_out->face_start);
+	free(data_out->face_vertex_index);
+	free(data_out->face_normal_index);
+	free(data_out->face_texture_index);
+	free(data_out->face_material_index);
+	free(data_out->materials);
+	memset(data_out, 0, sizeof(obj_flat_scene_data));
+}
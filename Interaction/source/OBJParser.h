@@ -22,13 +22,23 @@
 #ifndef OBJ_PARSER_H
 #define OBJ_PARSER_H
 
+#include "Arena.h"
 #include "List.h"
 #include "StringExtra.h"
+#include "Vector.h"
 
 #define OBJ_FILENAME_LENGTH 500
 #define MATERIAL_NAME_SIZE 255
-#define OBJ_LINE_SIZE 500
-#define MAX_VERTEX_COUNT 4 //can only handle quads or triangles
+#define MAX_VERTEX_COUNT 4 //corners of an obj_face, longer faces become fans
+#define OBJ_PARALLEL_MIN_CHUNK_SIZE (256*1024)
+#define OBJ_PARALLEL_CHUNKS_PER_THREAD 4
+
+//precision of the flat scene arrays, build with -DOBJ_REAL_DOUBLE for double
+#ifdef OBJ_REAL_DOUBLE
+typedef double obj_real;
+#else
+typedef float obj_real;
+#endif
 
 typedef struct 
 {
@@ -62,6 +72,9 @@ typedef struct
 	double e[3];
 } obj_vector;
 
+VECTOR_DECLARE(obj_vectors, obj_vector)
+VECTOR_DECLARE(obj_faces, obj_face)
+
 typedef struct
 {
 	char name[MATERIAL_NAME_SIZE];
@@ -109,11 +122,11 @@ typedef struct
 	char scene_filename[OBJ_FILENAME_LENGTH];
 	char material_filename[OBJ_FILENAME_LENGTH];
 	
-	list vertex_list;
-	list vertex_normal_list;
-	list vertex_texture_list;
+	obj_vectors vertex_list;
+	obj_vectors vertex_normal_list;
+	obj_vectors vertex_texture_list;
 	
-	list face_list;
+	obj_faces face_list;
 	list sphere_list;
 	list plane_list;
 	
@@ -124,6 +137,8 @@ typedef struct
 	list material_list;
 	
 	obj_camera *camera;
+
+	arena storage; //backs every element referenced by the lists
 } obj_growable_scene_data;
 
 typedef struct
@@ -157,9 +172,77 @@ typedef struct
 	int material_count;
 
 	obj_camera *camera;
+
+	//vertices and faces the lists point into
+	obj_vector *vertex_storage;
+	obj_vector *vertex_normal_storage;
+	obj_vector *vertex_texture_storage;
+	obj_face *face_storage;
+
+	arena storage; //backs every other element referenced by the lists
 } obj_scene_data;
 
+/* Flat structure-of-arrays layout: 3 reals per vertex, normal and
+ * texture coordinate, face corners stored back to back with face i
+ * using corners face_start[i] .. face_start[i+1]-1. Only geometry and
+ * materials are kept. */
+typedef struct
+{
+	obj_real *vertices;
+	obj_real *vertex_normals;
+	obj_real *vertex_textures;
+
+	int *face_start;            //face_count+1 entries
+	int *face_vertex_index;     //one per corner
+	int *face_normal_index;
+	int *face_texture_index;
+	int *face_material_index;   //one per face
+
+	obj_material *materials;
+
+	int vertex_count;
+	int vertex_normal_count;
+	int vertex_texture_count;
+
+	int face_count;
+	int face_corner_count;
+
+	int material_count;
+} obj_flat_scene_data;
+
+/* Face with every corner of its line, as passed to the polygon
+ * callback; the arrays are only valid during the call */
+typedef struct
+{
+	const int *vertex_index;
+	const int *normal_index;
+	const int *texture_index;
+	int vertex_count;
+	int material_index;
+} obj_polygon;
+
+/* Callbacks receiving the elements of a file one at a time while it
+ * is parsed; face indices are already resolved to 0-based indices and
+ * material_index refers to the order of the material callbacks. Any
+ * callback may be NULL. A face line is passed once to polygon and, as
+ * for obj_scene_data, to face as one obj_face or, with more than
+ * MAX_VERTEX_COUNT corners, as a fan of triangles around its first
+ * corner. Spheres, planes, lights and the camera are not streamed. */
+typedef struct
+{
+	void (*vertex)(void *context, const obj_vector *vertex);
+	void (*vertex_normal)(void *context, const obj_vector *normal);
+	void (*vertex_texture)(void *context, const obj_vector *texture);
+	void (*face)(void *context, const obj_face *face);
+	void (*polygon)(void *context, const obj_polygon *polygon);
+	void (*material)(void *context, const obj_material *material);
+} obj_stream_callbacks;
+
 int parse_obj_scene(obj_scene_data *data_out, char *filename);
+int parse_obj_scene_parallel(obj_scene_data *data_out, char *filename, int thread_count);
+int parse_obj_stream(char *filename, const obj_stream_callbacks *callbacks, void *context);
 void delete_obj_data(obj_scene_data *data_out);
+int parse_obj_scene_flat(obj_flat_scene_data *data_out, char *filename);
+void delete_obj_flat_data(obj_flat_scene_data *data_out);
 
 #endif
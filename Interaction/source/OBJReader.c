@@ -0,0 +1,212 @@
+/******************************************************************
+*
+* OBJReader.c
+*
+* Description: Line and token access to OBJ/MTL files without
+*              copying. Regular files are memory-mapped; pipes and
+*              other streams are read into a buffer with read().
+*              Lines have no length limit and tokens point directly
+*              into the file contents.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* POSIX includes */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "OBJReader.h"
+#include "OBJScan.h"
+
+#define OBJ_READ_CHUNK_SIZE (1024*1024)
+
+
+// internal helper functions
+char obj_is_blank(char c)
+{
+	return(c == ' ' || c == '\t' || c == '\r');
+}
+
+int obj_reader_map(obj_reader *reader, int fd, size_t size)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+	void *mapping;
+
+	if(size == 0)
+		return 0;
+
+	mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(mapping == MAP_FAILED)
+		return 0;
+
+	//number parsing stops at the first byte that is not part of the
+	//token; past the end of the file that byte is the zero fill of the
+	//last page, so a file filling its last page exactly must end in
+	//whitespace to be mapped
+	if(size % page_size == 0)
+	{
+		char last = ((const char*)mapping)[size-1];
+		if(last != '\n' && !obj_is_blank(last))
+		{
+			munmap(mapping, size);
+			return 0;
+		}
+	}
+
+#ifdef MADV_SEQUENTIAL
+	madvise(mapping, size, MADV_SEQUENTIAL);
+#endif
+
+	reader->data = (const char*)mapping;
+	reader->size = size;
+	reader->map_size = size;
+	return 1;
+}
+
+int obj_reader_read(obj_reader *reader, int fd)
+{
+	size_t capacity = OBJ_READ_CHUNK_SIZE;
+	size_t size = 0;
+	ssize_t count;
+	char *buffer = (char*) malloc(capacity + 1);
+	char *grown;
+
+	if(buffer == NULL)
+		return 0;
+
+	while( (count = read(fd, buffer + size, capacity - size)) != 0 )
+	{
+		if(count < 0)
+		{
+			free(buffer);
+			return 0;
+		}
+
+		size += count;
+		if(size == capacity)
+		{
+			capacity *= 2;
+			grown = (char*) realloc(buffer, capacity + 1);
+			if(grown == NULL)
+			{
+				free(buffer);
+				return 0;
+			}
+			buffer = grown;
+		}
+	}
+
+	buffer[size] = '\0';
+	reader->data = buffer;
+	reader->size = size;
+	reader->map_size = 0;
+	return 1;
+}
+//end helpers
+
+int obj_reader_open(obj_reader *reader, const char *filename)
+{
+	struct stat info;
+	int fd;
+	int success = 0;
+
+	fd = open(filename, O_RDONLY);
+	if(fd < 0)
+		return 0;
+
+	if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+		success = obj_reader_map(reader, fd, (size_t)info.st_size);
+
+	//pipes, empty files and files that can not be mapped safely
+	if(!success)
+		success = obj_reader_read(reader, fd);
+
+	close(fd);
+
+	reader->cursor = reader->data;
+	reader->line_number = 0;
+	return success;
+}
+
+int obj_reader_next_line(obj_reader *reader, obj_line *line)
+{
+	const char *end = reader->data + reader->size;
+	const char *newline;
+
+	if(reader->cursor >= end)
+		return 0;
+
+	newline = obj_scan_newline(reader->cursor, end);
+
+	line->begin = reader->cursor;
+	line->end = newline;
+	line->cursor = reader->cursor;
+
+	reader->cursor = newline < end ? newline + 1 : end;
+	reader->line_number++;
+	return 1;
+}
+
+void obj_reader_close(obj_reader *reader)
+{
+	if(reader->map_size != 0)
+		munmap((void*)reader->data, reader->map_size);
+	else
+		free((void*)reader->data);
+
+	reader->data = NULL;
+	reader->size = 0;
+	reader->map_size = 0;
+}
+
+int obj_line_next_token(obj_line *line, obj_token *token)
+{
+	const char *p = line->cursor;
+	const char *begin;
+
+	while(p < line->end && obj_is_blank(*p))
+		p++;
+
+	if(p == line->end)
+	{
+		line->cursor = p;
+		return 0;
+	}
+
+	begin = p;
+	while(p < line->end && !obj_is_blank(*p))
+		p++;
+
+	token->begin = begin;
+	token->length = (int)(p - begin);
+	line->cursor = p;
+	return 1;
+}
+
+char obj_token_equal(const obj_token *token, const char *keyword)
+{
+	return(strncmp(token->begin, keyword, token->length) == 0 && keyword[token->length] == '\0');
+}
+
+void obj_token_copy(const obj_token *token, char *destination, int destination_size)
+{
+	int length = token->length;
+
+	if(length > destination_size - 1)
+		length = destination_size - 1;
+
+	memcpy(destination, token->begin, length);
+	destination[length] = '\0';
+}
@@ -0,0 +1,54 @@
+/******************************************************************
+*
+* OBJReader.h
+*
+* Description: Line and token access to OBJ/MTL files without
+*              copying. Regular files are memory-mapped; pipes and
+*              other streams are read into a buffer with read().
+*              Lines have no length limit and tokens point directly
+*              into the file contents.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef OBJ_READER_H
+#define OBJ_READER_H
+
+#include <stddef.h>
+
+typedef struct
+{
+	const char *data;   //file contents; a byte that stops number parsing always follows
+	size_t size;
+	size_t map_size;    //non-zero if data is a mapping
+	const char *cursor;
+	int line_number;
+} obj_reader;
+
+typedef struct
+{
+	const char *begin;
+	const char *end;    //exclusive, newline not included
+	const char *cursor; //next token starts here
+} obj_line;
+
+typedef struct
+{
+	const char *begin;
+	int length;
+} obj_token;
+
+int obj_reader_open(obj_reader *reader, const char *filename);
+int obj_reader_next_line(obj_reader *reader, obj_line *line);
+void obj_reader_close(obj_reader *reader);
+
+int obj_line_next_token(obj_line *line, obj_token *token);
+char obj_token_equal(const obj_token *token, const char *keyword);
+void obj_token_copy(const obj_token *token, char *destination, int destination_size);
+
+#endif
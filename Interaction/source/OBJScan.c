@@ -0,0 +1,271 @@
+/******************************************************************
+*
+* OBJScan.c
+*
+* Description: Parsing kernel for the OBJ reader: keyword lookup,
+*              locale independent number parsing, single pass
+*              "v/vt/vn" index scanning and vectorized newline
+*              search. All functions work on [begin, end) ranges
+*              and never need a terminated string.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#define _GNU_SOURCE         /* strtod_l */
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <locale.h>
+#include <pthread.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "OBJScan.h"
+
+/* Largest mantissa and power of ten that are exact in a double; within
+ * these limits a single multiply or divide is correctly rounded and
+ * matches strtod bit for bit (Clinger's fast path) */
+#define OBJ_SCAN_MAX_EXACT_MANTISSA (1ULL << 53)
+#define OBJ_SCAN_MAX_EXACT_POWER 22
+
+static const double obj_scan_powers_of_ten[OBJ_SCAN_MAX_EXACT_POWER + 1] =
+{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+	1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* C locale of the slow path, made once by whichever thread parses
+ * first; strtod alone would read "0.5" as 0 under a decimal comma */
+static locale_t obj_scan_c_locale = (locale_t)0;
+static pthread_once_t obj_scan_locale_once = PTHREAD_ONCE_INIT;
+
+
+// internal helper functions
+void obj_scan_make_locale()
+{
+	obj_scan_c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+
+/* strtod in the C locale; only if that locale can not be created does
+ * the locale of the process apply */
+double obj_scan_strtod(const char *begin)
+{
+	pthread_once(&obj_scan_locale_once, obj_scan_make_locale);
+	if(obj_scan_c_locale == (locale_t)0)
+		return strtod(begin, NULL);
+	return strtod_l(begin, NULL, obj_scan_c_locale);
+}
+//end helpers
+
+
+obj_keyword obj_scan_keyword(const char *begin, int length)
+{
+	//dispatch on the leading byte, the common keywords are one or two bytes long
+	switch(begin[0])
+	{
+		case 'v':
+			if(length == 1)
+				return OBJ_KEY_VERTEX;
+			if(length == 2 && begin[1] == 'n')
+				return OBJ_KEY_NORMAL;
+			if(length == 2 && begin[1] == 't')
+				return OBJ_KEY_TEXTURE;
+			break;
+
+		case 'f':
+			if(length == 1)
+				return OBJ_KEY_FACE;
+			break;
+
+		case 's':
+			if(length == 1)
+				return OBJ_KEY_SMOOTHING;
+			if(length == 2 && begin[1] == 'p')
+				return OBJ_KEY_SPHERE;
+			break;
+
+		case 'p':
+			if(length == 1)
+				return OBJ_KEY_POINT;
+			if(length == 2 && begin[1] == 'l')
+				return OBJ_KEY_PLANE;
+			break;
+
+		case 'l':
+			if(length == 2 && begin[1] == 'p')
+				return OBJ_KEY_LIGHT_POINT;
+			if(length == 2 && begin[1] == 'd')
+				return OBJ_KEY_LIGHT_DISC;
+			if(length == 2 && begin[1] == 'q')
+				return OBJ_KEY_LIGHT_QUAD;
+			break;
+
+		case 'c':
+			if(length == 1)
+				return OBJ_KEY_CAMERA;
+			break;
+
+		case 'u':
+			if(length == 6 && memcmp(begin, "usemtl", 6) == 0)
+				return OBJ_KEY_USEMTL;
+			break;
+
+		case 'm':
+			if(length == 6 && memcmp(begin, "mtllib", 6) == 0)
+				return OBJ_KEY_MTLLIB;
+			break;
+
+		case 'o':
+			if(length == 1)
+				return OBJ_KEY_OBJECT;
+			break;
+
+		case 'g':
+			if(length == 1)
+				return OBJ_KEY_GROUP;
+			break;
+	}
+
+	return OBJ_KEY_UNKNOWN;
+}
+
+double obj_scan_double(const char *begin, const char *end)
+{
+	const char *p = begin;
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	int exponent_value = 0;
+	char negative = 0;
+	char exponent_negative = 0;
+	double value;
+
+	if(p < end && (*p == '-' || *p == '+'))
+		negative = (*p++ == '-');
+
+	//skip leading zeros, they do not count as significant digits
+	while(p < end && *p == '0')
+		p++;
+
+	for(; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+		mantissa = mantissa*10 + (*p - '0');
+
+	if(p < end && *p == '.')
+	{
+		p++;
+		if(digits == 0)
+		{
+			while(p < end && *p == '0')
+			{
+				p++;
+				exponent--;
+			}
+		}
+		for(; p < end && *p >= '0' && *p <= '9'; p++, digits++, exponent--)
+			mantissa = mantissa*10 + (*p - '0');
+	}
+
+	if(p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		if(p < end && (*p == '-' || *p == '+'))
+			exponent_negative = (*p++ == '-');
+		if(p == end || *p < '0' || *p > '9')
+			return obj_scan_strtod(begin);
+		for(; p < end && *p >= '0' && *p <= '9' && exponent_value < 10000; p++)
+			exponent_value = exponent_value*10 + (*p - '0');
+		exponent += exponent_negative ? -exponent_value : exponent_value;
+	}
+
+	//anything the fast path can not represent exactly (long mantissas,
+	//large exponents, hex, inf, nan) goes through the C library
+	if(digits > 19 || mantissa > OBJ_SCAN_MAX_EXACT_MANTISSA ||
+	   exponent < -OBJ_SCAN_MAX_EXACT_POWER || exponent > OBJ_SCAN_MAX_EXACT_POWER ||
+	   (p < end && (*p == 'x' || *p == 'X' || *p == 'n' || *p == 'N' || *p == 'i' || *p == 'I')))
+		return obj_scan_strtod(begin);
+
+	value = (double)mantissa;
+	if(exponent < 0)
+		value /= obj_scan_powers_of_ten[-exponent];
+	else
+		value *= obj_scan_powers_of_ten[exponent];
+
+	return negative ? -value : value;
+}
+
+int obj_scan_int(const char *begin, const char *end, const char **stop)
+{
+	const char *p = begin;
+	int value = 0;
+	char negative = 0;
+
+	if(p < end && (*p == '-' || *p == '+'))
+		negative = (*p++ == '-');
+
+	for(; p < end && *p >= '0' && *p <= '9'; p++)
+		value = value*10 + (*p - '0');
+
+	if(stop != NULL)
+		*stop = p;
+
+	return negative ? -value : value;
+}
+
+void obj_scan_index(const char *begin, const char *end, int *vertex, int *texture, int *normal)
+{
+	const char *p;
+
+	*vertex = obj_scan_int(begin, end, &p);
+	*texture = 0;
+	*normal = 0;
+
+	//skip anything up to the first separator, as atoi would have
+	while(p < end && *p != '/')
+		p++;
+	if(p == end)
+		return;
+
+	*texture = obj_scan_int(++p, end, &p);
+
+	while(p < end && *p != '/')
+		p++;
+	if(p == end)
+		return;
+
+	*normal = obj_scan_int(++p, end, NULL);
+}
+
+const char* obj_scan_newline(const char *begin, const char *end)
+{
+	const char *p = begin;
+
+#ifdef __SSE2__
+	const __m128i newline = _mm_set1_epi8('\n');
+	int mask;
+
+	for(; end - p >= 16; p += 16)
+	{
+		mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), newline));
+		if(mask != 0)
+			return p + __builtin_ctz(mask);
+	}
+#endif
+
+	for(; p < end; p++)
+	{
+		if(*p == '\n')
+			return p;
+	}
+
+	return end;
+}
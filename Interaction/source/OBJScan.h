@@ -0,0 +1,49 @@
+/******************************************************************
+*
+* OBJScan.h
+*
+* Description: Parsing kernel for the OBJ reader: keyword lookup,
+*              locale independent number parsing, single pass
+*              "v/vt/vn" index scanning and vectorized newline
+*              search. All functions work on [begin, end) ranges
+*              and never need a terminated string.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef OBJ_SCAN_H
+#define OBJ_SCAN_H
+
+typedef enum
+{
+	OBJ_KEY_UNKNOWN = 0,
+	OBJ_KEY_VERTEX,
+	OBJ_KEY_NORMAL,
+	OBJ_KEY_TEXTURE,
+	OBJ_KEY_FACE,
+	OBJ_KEY_SPHERE,
+	OBJ_KEY_PLANE,
+	OBJ_KEY_POINT,
+	OBJ_KEY_LIGHT_POINT,
+	OBJ_KEY_LIGHT_DISC,
+	OBJ_KEY_LIGHT_QUAD,
+	OBJ_KEY_CAMERA,
+	OBJ_KEY_USEMTL,
+	OBJ_KEY_MTLLIB,
+	OBJ_KEY_OBJECT,
+	OBJ_KEY_SMOOTHING,
+	OBJ_KEY_GROUP
+} obj_keyword;
+
+obj_keyword obj_scan_keyword(const char *begin, int length);
+double obj_scan_double(const char *begin, const char *end);
+int obj_scan_int(const char *begin, const char *end, const char **stop);
+void obj_scan_index(const char *begin, const char *end, int *vertex, int *texture, int *normal);
+const char* obj_scan_newline(const char *begin, const char *end);
+
+#endif
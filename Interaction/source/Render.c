@@ -0,0 +1,507 @@
+/******************************************************************
+*
+* Render.c
+*
+* Description: Thin layer between the application and OpenGL with
+*              a shadow copy of the GL state and per frame counters
+*              of issued and filtered calls.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+
+#include "Render.h"
+
+#define RENDER_MATRIX_SIZE (16 * sizeof(GLfloat))
+
+
+// internal helper functions
+/* Point the four matrix attributes at the matrix of one command */
+void render_matrix_pointers(render_state *state, render_arena *arena, int first)
+{
+	int i;
+
+	render_bind_buffer(state, GL_ARRAY_BUFFER, arena->matrix_buffer);
+	for(i=0; i<4; i++)
+		glVertexAttribPointer(RENDER_MATRIX + i, 4, GL_FLOAT, GL_FALSE, RENDER_MATRIX_SIZE,
+		                      (const GLvoid*)(first * RENDER_MATRIX_SIZE + i * 4 * sizeof(GLfloat)));
+	state->calls += 4;
+}
+
+/* Vertices of source in the layout of the arena; attributes the
+ * source lacks are zero, those the arena lacks are dropped */
+void render_arena_convert(const render_arena *arena, const mesh *source, float *vertices)
+{
+	int source_texture = mesh_texture_offset(source->format);
+	int arena_texture = mesh_texture_offset(arena->format);
+	const float *in;
+	float *out;
+	int i;
+
+	for(i=0; i<source->vertex_count; i++)
+	{
+		in = source->vertices + i * source->vertex_size;
+		out = vertices + i * arena->vertex_size;
+		memset(out, 0, sizeof(float) * arena->vertex_size);
+		memcpy(out, in, sizeof(float) * 3);
+
+		if((arena->format & MESH_NORMAL) && (source->format & MESH_NORMAL))
+			memcpy(out + MESH_NORMAL_OFFSET, in + MESH_NORMAL_OFFSET, sizeof(float) * 3);
+		if((arena->format & MESH_TEXTURE) && (source->format & MESH_TEXTURE))
+			memcpy(out + arena_texture, in + source_texture, sizeof(float) * 2);
+	}
+}
+
+/* Indices of source widened to the index size of the arena */
+void render_arena_widen(const render_arena *arena, const mesh *source, void *indices)
+{
+	unsigned int index;
+	int i;
+
+	for(i=0; i<source->index_count; i++)
+	{
+		if(source->index_size == 1)
+			index = ((const unsigned char*)source->indices)[i];
+		else if(source->index_size == 2)
+			index = ((const unsigned short*)source->indices)[i];
+		else
+			index = ((const unsigned int*)source->indices)[i];
+
+		if(arena->index_size == 1)
+			((unsigned char*)indices)[i] = (unsigned char)index;
+		else if(arena->index_size == 2)
+			((unsigned short*)indices)[i] = (unsigned short)index;
+		else
+			((unsigned int*)indices)[i] = index;
+	}
+}
+
+/* Indices of the full detail level; coarser levels follow them */
+GLsizei render_full_index_count(const mesh *source)
+{
+	if(source->lod_count > 0)
+		return source->lods[0].index_count;
+	return source->index_count;
+}
+//end helpers
+
+GLenum render_index_type(int index_size)
+{
+	if(index_size == 1)
+		return GL_UNSIGNED_BYTE;
+	if(index_size == 2)
+		return GL_UNSIGNED_SHORT;
+	return GL_UNSIGNED_INT;
+}
+
+void render_state_make(render_state *state)
+{
+	memset(state, 0, sizeof(render_state));
+}
+
+/* Forget the shadowed state, e.g. after GL calls made elsewhere */
+void render_state_reset(render_state *state)
+{
+	state->program_known = 0;
+	state->vertex_array_known = 0;
+	state->polygon_mode_known = 0;
+	state->array_buffer_known = 0;
+	state->indirect_buffer_known = 0;
+}
+
+void render_frame_begin(render_state *state)
+{
+	state->calls = 0;
+	state->filtered = 0;
+	state->draws = 0;
+	state->triangles = 0;
+}
+
+void render_frame_end(render_state *state)
+{
+	state->frame_calls = state->calls;
+	state->frame_filtered = state->filtered;
+	state->frame_draws = state->draws;
+	state->frame_triangles = state->triangles;
+}
+
+void render_use_program(render_state *state, GLuint program)
+{
+	if(state->program_known && state->program == program)
+	{
+		state->filtered++;
+		return;
+	}
+
+	glUseProgram(program);
+	state->calls++;
+	state->program = program;
+	state->program_known = 1;
+}
+
+void render_bind_vertex_array(render_state *state, GLuint vertex_array)
+{
+	if(state->vertex_array_known && state->vertex_array == vertex_array)
+	{
+		state->filtered++;
+		return;
+	}
+
+	glBindVertexArray(vertex_array);
+	state->calls++;
+	state->vertex_array = vertex_array;
+	state->vertex_array_known = 1;
+}
+
+/* Buffer bindings outside of vertex arrays are shadowed */
+void render_bind_buffer(render_state *state, GLenum target, GLuint buffer)
+{
+	if(target == GL_ARRAY_BUFFER)
+	{
+		if(state->array_buffer_known && state->array_buffer == buffer)
+		{
+			state->filtered++;
+			return;
+		}
+		state->array_buffer = buffer;
+		state->array_buffer_known = 1;
+	}
+	else if(target == GL_DRAW_INDIRECT_BUFFER)
+	{
+		if(state->indirect_buffer_known && state->indirect_buffer == buffer)
+		{
+			state->filtered++;
+			return;
+		}
+		state->indirect_buffer = buffer;
+		state->indirect_buffer_known = 1;
+	}
+
+	glBindBuffer(target, buffer);
+	state->calls++;
+}
+
+void render_polygon_mode(render_state *state, GLenum mode)
+{
+	if(state->polygon_mode_known && state->polygon_mode == mode)
+	{
+		state->filtered++;
+		return;
+	}
+
+	glPolygonMode(GL_FRONT_AND_BACK, mode);
+	state->calls++;
+	state->polygon_mode = mode;
+	state->polygon_mode_known = 1;
+}
+
+void render_clear(render_state *state, GLbitfield mask)
+{
+	glClear(mask);
+	state->calls++;
+}
+
+/* Buffers for up to vertex_capacity vertices of the given format and
+ * index_capacity indices of index_size bytes; the vertex array stays
+ * bound */
+int render_arena_make(render_state *state, render_arena *arena, int format, 
+                      int vertex_capacity, int index_capacity, int index_size)
+{
+	GLsizei stride;
+	int i;
+
+	memset(arena, 0, sizeof(render_arena));
+	arena->format = format;
+	arena->vertex_size = mesh_vertex_size(format);
+	arena->vertex_capacity = vertex_capacity;
+	arena->index_capacity = index_capacity;
+	arena->index_size = index_size;
+	arena->index_type = render_index_type(index_size);
+	arena->indirect = GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+	render_indirect_commands_make(&arena->ranges, 0);
+	int_vector_make(&arena->next_instance, 0);
+	float_vector_make(&arena->matrices, 0);
+	render_indirect_commands_make(&arena->draws, 0);
+
+	glGenVertexArrays(1, &arena->vertex_array);
+	glGenBuffers(1, &arena->vertex_buffer);
+	glGenBuffers(1, &arena->index_buffer);
+	glGenBuffers(1, &arena->matrix_buffer);
+	state->calls += 4;
+	if(arena->indirect)
+	{
+		glGenBuffers(1, &arena->indirect_buffer);
+		state->calls++;
+	}
+	if(arena->vertex_array == 0 || arena->vertex_buffer == 0 || arena->index_buffer == 0 || 
+	   arena->matrix_buffer == 0 || (arena->indirect && arena->indirect_buffer == 0))
+		return 0;
+
+	stride = arena->vertex_size * sizeof(GLfloat);
+	render_bind_vertex_array(state, arena->vertex_array);
+
+	render_bind_buffer(state, GL_ARRAY_BUFFER, arena->vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertex_capacity * stride, NULL, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(RENDER_POSITION);
+	glVertexAttribPointer(RENDER_POSITION, 3, GL_FLOAT, GL_FALSE, stride, 0);
+	state->calls += 3;
+
+	if(format & MESH_NORMAL)
+	{
+		glEnableVertexAttribArray(RENDER_NORMAL);
+		glVertexAttribPointer(RENDER_NORMAL, 3, GL_FLOAT, GL_FALSE, stride,
+		                      (const GLvoid*)(MESH_NORMAL_OFFSET * sizeof(GLfloat)));
+		state->calls += 2;
+	}
+
+	//one matrix per instance; the base instance selects the command
+	for(i=0; i<4; i++)
+	{
+		glEnableVertexAttribArray(RENDER_MATRIX + i);
+		glVertexAttribDivisor(RENDER_MATRIX + i, 1);
+		state->calls += 2;
+	}
+	render_matrix_pointers(state, arena, 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena->index_buffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)index_capacity * index_size, NULL, GL_STATIC_DRAW);
+	state->calls += 2;
+
+	return 1;
+}
+
+/* Copy a mesh into the free part of the arena; fails if it does not
+ * fit or needs wider indices than the arena has */
+int render_arena_add(render_state *state, render_arena *arena, render_mesh *mesh_o, const mesh *source)
+{
+	GLsizei stride = arena->vertex_size * sizeof(GLfloat);
+	render_indirect_command *range;
+	void *staging = NULL;
+	const void *vertices = source->vertices;
+	const void *indices = source->indices;
+
+	if(arena->vertex_count + source->vertex_count > arena->vertex_capacity ||
+	   arena->index_count + source->index_count > arena->index_capacity ||
+	   source->index_size > arena->index_size ||
+	   !render_indirect_commands_reserve(&arena->ranges, arena->ranges.count + 1))
+		return 0;
+
+	if(source->format != arena->format)
+	{
+		staging = malloc(sizeof(float) * arena->vertex_size * source->vertex_count);
+		if(staging == NULL)
+			return 0;
+		render_arena_convert(arena, source, (float*)staging);
+		vertices = staging;
+	}
+
+	render_bind_buffer(state, GL_ARRAY_BUFFER, arena->vertex_buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)arena->vertex_count * stride, 
+	                (GLsizeiptr)source->vertex_count * stride, vertices);
+	state->calls++;
+
+	if(source->index_size != arena->index_size)
+	{
+		free(staging);
+		staging = malloc((size_t)arena->index_size * source->index_count);
+		if(staging == NULL)
+			return 0;
+		render_arena_widen(arena, source, staging);
+		indices = staging;
+	}
+
+	render_bind_vertex_array(state, arena->vertex_array);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)arena->index_count * arena->index_size, 
+	                (GLsizeiptr)source->index_count * arena->index_size, indices);
+	state->calls++;
+	free(staging);
+
+	mesh_o->index_count = render_full_index_count(source);
+	mesh_o->first_index = arena->index_count;
+	mesh_o->base_vertex = arena->vertex_count;
+	mesh_o->arena_index = arena->ranges.count;
+
+	range = render_indirect_commands_push(&arena->ranges);
+	range->count = mesh_o->index_count;
+	range->instance_count = 0;
+	range->first_index = mesh_o->first_index;
+	range->base_vertex = mesh_o->base_vertex;
+	range->base_instance = 0;
+
+	arena->vertex_count += source->vertex_count;
+	arena->index_count += source->index_count;
+	return 1;
+}
+
+/* A coarser level of a mesh added to the arena, drawn from the same
+ * buffers; it gets its own range, so its instances are batched apart
+ * from the base. Levels of a mesh without a range have none either */
+int render_mesh_level(render_arena *arena, const render_mesh *base, const mesh *source, int level, render_mesh *mesh_o)
+{
+	render_indirect_command *range;
+
+	if(level < 0 || level >= source->lod_count)
+		return 0;
+
+	*mesh_o = *base;
+	mesh_o->first_index = base->first_index + source->lods[level].first_index;
+	mesh_o->index_count = source->lods[level].index_count;
+	if(level == 0 || base->arena_index < 0)
+		return 1;
+
+	if(arena == NULL || !render_indirect_commands_reserve(&arena->ranges, arena->ranges.count + 1))
+		return 0;
+
+	mesh_o->arena_index = arena->ranges.count;
+	range = render_indirect_commands_push(&arena->ranges);
+	range->count = mesh_o->index_count;
+	range->instance_count = 0;
+	range->first_index = mesh_o->first_index;
+	range->base_vertex = mesh_o->base_vertex;
+	range->base_instance = 0;
+	return 1;
+}
+
+/* Draw commands whose meshes belong to the arena, those of the same
+ * mesh as instances of one draw; matrices go to the instance
+ * attribute stream instead of a uniform */
+void render_arena_execute(render_state *state, render_arena *arena, const render_command *commands, int count)
+{
+	render_indirect_command *range, *draw;
+	int mesh_count = arena->ranges.count;
+	int instance_count = 0;
+	int draw_count = 0;
+	char changed = 0;
+	int i, k;
+
+	if(count <= 0)
+		return;
+
+	if(!float_vector_reserve(&arena->matrices, count * 16) ||
+	   !int_vector_reserve(&arena->next_instance, mesh_count) ||
+	   !render_indirect_commands_reserve(&arena->draws, mesh_count))
+		return;
+
+	for(k=0; k<mesh_count; k++)
+		arena->ranges.items[k].instance_count = 0;
+	for(i=0; i<count; i++)
+	{
+		k = commands[i].mesh->arena_index;
+		if(k >= 0 && k < mesh_count)
+			arena->ranges.items[k].instance_count++;
+	}
+
+	//the matrices of one mesh are consecutive from its base instance
+	for(k=0; k<mesh_count; k++)
+	{
+		range = &arena->ranges.items[k];
+		range->base_instance = instance_count;
+		arena->next_instance.items[k] = instance_count;
+		instance_count += range->instance_count;
+	}
+	for(i=0; i<count; i++)
+	{
+		k = commands[i].mesh->arena_index;
+		if(k >= 0 && k < mesh_count)
+			memcpy(arena->matrices.items + 16 * arena->next_instance.items[k]++, commands[i].matrix, RENDER_MATRIX_SIZE);
+	}
+	arena->matrices.count = instance_count * 16;
+	if(instance_count == 0)
+		return;
+
+	render_bind_vertex_array(state, arena->vertex_array);
+
+	//whole buffer replaced, so the driver need not wait for the last frame
+	render_bind_buffer(state, GL_ARRAY_BUFFER, arena->matrix_buffer);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)instance_count * RENDER_MATRIX_SIZE, arena->matrices.items, GL_STREAM_DRAW);
+	state->calls++;
+
+	//without base instances the attributes are moved to the first matrix
+	if(!arena->indirect)
+	{
+		for(k=0; k<mesh_count; k++)
+		{
+			range = &arena->ranges.items[k];
+			if(range->instance_count == 0)
+				continue;
+
+			render_matrix_pointers(state, arena, range->base_instance);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range->count, arena->index_type,
+			                                  (const GLvoid*)((size_t)range->first_index * arena->index_size),
+			                                  range->instance_count, range->base_vertex);
+			state->calls++;
+			state->draws++;
+			state->triangles += range->count / 3 * range->instance_count;
+		}
+		return;
+	}
+
+	//the draw list only changes when the instance counts do
+	for(k=0; k<mesh_count; k++)
+	{
+		range = &arena->ranges.items[k];
+		if(range->instance_count == 0)
+			continue;
+
+		draw = &arena->draws.items[draw_count];
+		if(draw_count >= arena->uploaded_draws || memcmp(draw, range, sizeof(render_indirect_command)) != 0)
+		{
+			*draw = *range;
+			changed = 1;
+		}
+		state->triangles += range->count / 3 * range->instance_count;
+		draw_count++;
+	}
+	changed |= draw_count != arena->uploaded_draws;
+	arena->draws.count = draw_count;
+
+	render_bind_buffer(state, GL_DRAW_INDIRECT_BUFFER, arena->indirect_buffer);
+	if(changed)
+	{
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(render_indirect_command) * draw_count, arena->draws.items, GL_STATIC_DRAW);
+		arena->uploaded_draws = draw_count;
+		state->calls++;
+	}
+	else
+		state->filtered++;
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, arena->index_type, 0, draw_count, 0);
+	state->calls++;
+	state->draws++;
+}
+
+void render_arena_free(render_state *state, render_arena *arena)
+{
+	if(state->vertex_array_known && state->vertex_array == arena->vertex_array)
+		state->vertex_array = 0;
+	if(state->array_buffer_known && 
+	   (state->array_buffer == arena->vertex_buffer || state->array_buffer == arena->matrix_buffer))
+		state->array_buffer = 0;
+	if(state->indirect_buffer_known && state->indirect_buffer == arena->indirect_buffer)
+		state->indirect_buffer = 0;
+
+	glDeleteBuffers(1, &arena->vertex_buffer);
+	glDeleteBuffers(1, &arena->index_buffer);
+	glDeleteBuffers(1, &arena->matrix_buffer);
+	glDeleteVertexArrays(1, &arena->vertex_array);
+	state->calls += 4;
+	if(arena->indirect)
+	{
+		glDeleteBuffers(1, &arena->indirect_buffer);
+		state->calls++;
+	}
+
+	render_indirect_commands_free(&arena->ranges);
+	int_vector_free(&arena->next_instance);
+	float_vector_free(&arena->matrices);
+	render_indirect_commands_free(&arena->draws);
+	memset(arena, 0, sizeof(render_arena));
+}
@@ -0,0 +1,149 @@
+/******************************************************************
+*
+* Render.h
+*
+* Description: Thin layer between the application and OpenGL. Meshes
+*              share one arena: a vertex and an index buffer they are
+*              sub-allocated from and drawn with base vertex offsets.
+*              A frame is a list of draw commands, each one mesh with
+*              its matrix. Commands of the same mesh become instances
+*              of one draw: their matrices are streamed next to each
+*              other into one buffer read as a per instance attribute.
+*              The frame goes out as a single
+*              glMultiDrawElementsIndirect call on GL 4.3, or as one
+*              instanced draw per mesh on older versions.
+*
+*              A mesh with levels of detail is uploaded whole; each
+*              coarser level is another render mesh over a part of
+*              its index range.
+*
+*              All state changes go through a shadow copy of the GL
+*              state, so calls that would not change anything are
+*              not issued. GL calls, filtered calls, draws and
+*              triangles are counted per frame.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __RENDER_H
+#define __RENDER_H
+
+#include <GL/glew.h>
+
+#include "Mesh.h"
+#include "Vector.h"
+
+/* Attribute locations of the vertex shader */
+#define RENDER_POSITION 0
+#define RENDER_NORMAL   1
+#define RENDER_MATRIX   2           //mat4 per instance, locations 2 to 5
+
+/* Part of an arena drawn as one mesh */
+typedef struct
+{
+	GLsizei index_count;
+	GLuint first_index;         //position in the index buffer of the arena
+	GLint base_vertex;          //added to every index
+	int arena_index;            //position among the meshes of the arena, -1 if none
+} render_mesh;
+
+typedef struct
+{
+	const render_mesh *mesh;
+	const float *matrix;        //16 floats, row-major
+} render_command;
+
+VECTOR_DECLARE(render_commands, render_command)
+
+/* Layout of glMultiDrawElementsIndirect commands */
+typedef struct
+{
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;
+} render_indirect_command;
+
+VECTOR_DECLARE(render_indirect_commands, render_indirect_command)
+
+/* Shared buffers of many meshes */
+typedef struct
+{
+	GLuint vertex_array;
+	GLuint vertex_buffer;
+	GLuint index_buffer;
+	GLuint matrix_buffer;       //one matrix per command, streamed every frame
+	GLuint indirect_buffer;
+
+	int format;                 //vertex layout of all meshes, see Mesh.h
+	int vertex_size;
+	int index_size;             //indices are relative to the base vertex
+	GLenum index_type;
+	int vertex_count;
+	int vertex_capacity;
+	int index_count;
+	int index_capacity;
+	int matrix_capacity;
+	char indirect;              //glMultiDrawElementsIndirect with base instances
+
+	render_indirect_commands ranges;  //indices of every mesh, instances of the frame
+	int_vector next_instance;   //per mesh, while sorting matrices by mesh
+	float_vector matrices;      //staging of the streamed matrices
+	render_indirect_commands draws;  //commands in the indirect buffer
+	int uploaded_draws;
+} render_arena;
+
+typedef struct
+{
+	//shadowed GL state, valid only where the known flag is set
+	GLuint program;
+	GLuint vertex_array;
+	GLenum polygon_mode;
+	GLuint array_buffer;
+	GLuint indirect_buffer;
+	char program_known;
+	char vertex_array_known;
+	char polygon_mode_known;
+	char array_buffer_known;
+	char indirect_buffer_known;
+
+	//counters of the current frame
+	unsigned int calls;         //GL calls issued
+	unsigned int filtered;      //redundant calls not issued
+	unsigned int draws;
+	unsigned int triangles;     //of all instances
+
+	//counters of the last finished frame
+	unsigned int frame_calls;
+	unsigned int frame_filtered;
+	unsigned int frame_draws;
+	unsigned int frame_triangles;
+} render_state;
+
+GLenum render_index_type(int index_size);
+
+void render_state_make(render_state *state);
+void render_state_reset(render_state *state);
+void render_frame_begin(render_state *state);
+void render_frame_end(render_state *state);
+
+void render_use_program(render_state *state, GLuint program);
+void render_bind_vertex_array(render_state *state, GLuint vertex_array);
+void render_bind_buffer(render_state *state, GLenum target, GLuint buffer);
+void render_polygon_mode(render_state *state, GLenum mode);
+void render_clear(render_state *state, GLbitfield mask);
+
+int render_arena_make(render_state *state, render_arena *arena, int format, 
+                      int vertex_capacity, int index_capacity, int index_size);
+int render_arena_add(render_state *state, render_arena *arena, render_mesh *mesh_o, const mesh *source);
+int render_mesh_level(render_arena *arena, const render_mesh *base, const mesh *source, int level, render_mesh *mesh_o);
+void render_arena_execute(render_state *state, render_arena *arena, const render_command *commands, int count);
+void render_arena_free(render_state *state, render_arena *arena);
+
+#endif
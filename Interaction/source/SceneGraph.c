@@ -0,0 +1,381 @@
+/******************************************************************
+*
+* SceneGraph.c
+*
+* Description: Flat transform hierarchy in depth first order with
+*              updates limited to the subtrees of changed nodes.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+
+#include "Matrix.h"
+#include "SceneGraph.h"
+
+
+// internal helper functions
+int scene_graph_compare_positions(const void *a, const void *b)
+{
+	return *(const int*)a - *(const int*)b;
+}
+
+/* Queue a node for the next update */
+void scene_graph_mark(scene_graph *graph, scene_node *node)
+{
+	if(node->local_dirty)
+		return;
+
+	//without room in the list the whole hierarchy is recomputed
+	if(!int_vector_reserve(&graph->dirty, graph->dirty.count + 1))
+	{
+		graph->sorted = 0;
+		return;
+	}
+
+	node->local_dirty = 1;
+	graph->dirty.items[graph->dirty.count++] = node->handle;
+}
+
+/* Bring the nodes into depth first order, children in the order they
+ * were added; parents must be known before this is called */
+int scene_graph_sort(scene_graph *graph)
+{
+	int count = graph->nodes.count;
+	scene_node *nodes = graph->nodes.items;
+	scene_node *sorted;
+	int *first_child, *children, *stack, *position;
+	int depth = 0, next = 0;
+	int i, p, child;
+
+	sorted = (scene_node*) malloc(sizeof(scene_node) * count + 1);
+	first_child = (int*) calloc(count + 1, sizeof(int));
+	children = (int*) malloc(sizeof(int) * count + 1);
+	stack = (int*) malloc(sizeof(int) * count + 1);
+	position = (int*) malloc(sizeof(int) * count + 1);
+
+	if(sorted == NULL || first_child == NULL || children == NULL || stack == NULL || position == NULL)
+	{
+		free(sorted); free(first_child); free(children); free(stack); free(position);
+		return 0;
+	}
+
+	//children of every node, listed from first_child[p] on
+	for(i=0; i<count; i++)
+		if(nodes[i].parent != SCENE_GRAPH_NONE)
+			first_child[nodes[i].parent + 1]++;
+	for(i=0; i<count; i++)
+		first_child[i + 1] += first_child[i];
+	memcpy(position, first_child, sizeof(int) * count);
+	for(i=0; i<count; i++)
+		if(nodes[i].parent != SCENE_GRAPH_NONE)
+			children[position[nodes[i].parent]++] = i;
+
+	//preorder walk from every root; children are pushed last first
+	for(i=0; i<count; i++)
+	{
+		if(nodes[i].parent != SCENE_GRAPH_NONE)
+			continue;
+
+		stack[depth++] = i;
+		while(depth > 0)
+		{
+			p = stack[--depth];
+			position[p] = next;
+			sorted[next++] = nodes[p];
+			for(child=first_child[p + 1] - 1; child>=first_child[p]; child--)
+				stack[depth++] = children[child];
+		}
+	}
+
+	//subtrees end where the last of their descendants does
+	for(i=0; i<count; i++)
+	{
+		if(sorted[i].parent != SCENE_GRAPH_NONE)
+			sorted[i].parent = position[sorted[i].parent];
+		sorted[i].end = i + 1;
+	}
+	for(i=count-1; i>0; i--)
+	{
+		p = sorted[i].parent;
+		if(p != SCENE_GRAPH_NONE && sorted[i].end > sorted[p].end)
+			sorted[p].end = sorted[i].end;
+	}
+
+	for(i=0; i<count; i++)
+		graph->position_of.items[sorted[i].handle] = i;
+	memcpy(nodes, sorted, sizeof(scene_node) * count);
+
+	free(sorted); free(first_child); free(children); free(stack); free(position);
+	return 1;
+}
+
+/* Local matrices of the marked nodes from first to end, evaluated
+ * together as one transform batch */
+int scene_graph_update_locals(scene_graph *graph, int first, int end)
+{
+	transform_batch *batch = &graph->batch;
+	scene_node *node;
+	int i, b;
+
+	batch->count = 0;
+	graph->batch_nodes.count = 0;
+	for(i=first; i<end; i++)
+	{
+		node = &graph->nodes.items[i];
+		if(!node->local_dirty)
+			continue;
+
+		b = transform_batch_add(batch);
+		if(b < 0 || !int_vector_reserve(&graph->batch_nodes, b + 1))
+			return 0;
+
+		batch->translation_x[b] = node->translation[0];
+		batch->translation_y[b] = node->translation[1];
+		batch->translation_z[b] = node->translation[2];
+		batch->rotation_x[b] = node->rotation[0];
+		batch->rotation_y[b] = node->rotation[1];
+		batch->rotation_z[b] = node->rotation[2];
+		batch->scale_x[b] = node->scale[0];
+		batch->scale_y[b] = node->scale[1];
+		batch->scale_z[b] = node->scale[2];
+		graph->batch_nodes.items[graph->batch_nodes.count++] = i;
+	}
+
+	if(batch->count == 0)
+		return 1;
+	if(!float_vector_reserve(&graph->batch_matrices, 16 * batch->count))
+		return 0;
+
+	//updates run on the calling thread, below the parallel threshold
+	//for any hierarchy of this size
+	transform_batch_evaluate(batch, graph->batch_matrices.items, NULL);
+
+	for(b=0; b<batch->count; b++)
+	{
+		i = graph->batch_nodes.items[b];
+		memcpy(graph->locals.items + 16*i, graph->batch_matrices.items + 16*b, sizeof(float) * 16);
+		graph->nodes.items[i].local_dirty = 0;
+	}
+
+	return 1;
+}
+
+/* Recompute local matrices where marked and world matrices of the
+ * nodes from first to end; parents before first must be current */
+int scene_graph_update_range(scene_graph *graph, int first, int end)
+{
+	scene_node *node;
+	float *local, *world;
+	int i;
+
+	if(!int_vector_reserve(&graph->changed, graph->changed.count + end - first) ||
+	   !scene_graph_update_locals(graph, first, end))
+		return 0;
+
+	for(i=first; i<end; i++)
+	{
+		node = &graph->nodes.items[i];
+		local = graph->locals.items + 16*i;
+		world = graph->worlds.items + 16*i;
+
+		if(node->parent == SCENE_GRAPH_NONE)
+			memcpy(world, local, sizeof(float) * 16);
+		else
+			MultiplyAffineMatrix(graph->worlds.items + 16*node->parent, local, world);
+
+		node->updated = graph->update_count;
+		graph->changed.items[graph->changed.count++] = node->handle;
+	}
+
+	return end - first;
+}
+//end helpers
+
+
+void scene_graph_make(scene_graph *graph)
+{
+	scene_nodes_make(&graph->nodes, 0);
+	float_vector_make(&graph->locals, 0);
+	float_vector_make(&graph->worlds, 0);
+	int_vector_make(&graph->position_of, 0);
+	int_vector_make(&graph->dirty, 0);
+	int_vector_make(&graph->changed, 0);
+	transform_batch_make(&graph->batch, 0);
+	int_vector_make(&graph->batch_nodes, 0);
+	float_vector_make(&graph->batch_matrices, 0);
+	graph->update_count = 0;
+	graph->sorted = 1;
+}
+
+/* Add a node with the identity transform below parent, a handle or
+ * SCENE_GRAPH_NONE; returns its handle or -1 */
+int scene_graph_add(scene_graph *graph, int parent)
+{
+	int count = graph->nodes.count;
+	int handle = graph->position_of.count;
+	scene_node *node;
+	int p;
+
+	if(parent != SCENE_GRAPH_NONE && (parent < 0 || parent >= handle))
+		return -1;
+
+	if(!scene_nodes_reserve(&graph->nodes, count + 1) ||
+	   !float_vector_reserve(&graph->locals, 16 * (count + 1)) ||
+	   !float_vector_reserve(&graph->worlds, 16 * (count + 1)) ||
+	   !int_vector_reserve(&graph->position_of, handle + 1) ||
+	   !int_vector_reserve(&graph->dirty, graph->dirty.count + 1))
+		return -1;
+
+	node = &graph->nodes.items[count];
+	memset(node, 0, sizeof(scene_node));
+	node->parent = parent == SCENE_GRAPH_NONE ? SCENE_GRAPH_NONE : graph->position_of.items[parent];
+	node->end = count + 1;
+	node->handle = handle;
+	node->scale[0] = node->scale[1] = node->scale[2] = 1.0f;
+
+	graph->nodes.count++;
+	graph->locals.count += 16;
+	graph->worlds.count += 16;
+	graph->position_of.items[graph->position_of.count++] = count;
+	scene_graph_mark(graph, node);
+
+	//appending keeps the order if the parent subtree ends last, as
+	//when a hierarchy is built depth first; its ancestors end there too
+	if(node->parent == SCENE_GRAPH_NONE)
+		return handle;
+	if(graph->nodes.items[node->parent].end != count)
+	{
+		graph->sorted = 0;
+		return handle;
+	}
+	for(p=node->parent; p != SCENE_GRAPH_NONE; p=graph->nodes.items[p].parent)
+		graph->nodes.items[p].end = count + 1;
+
+	return handle;
+}
+
+void scene_graph_set_translation(scene_graph *graph, int handle, float x, float y, float z)
+{
+	scene_node *node = &graph->nodes.items[graph->position_of.items[handle]];
+
+	if(node->translation[0] == x && node->translation[1] == y && node->translation[2] == z)
+		return;
+
+	node->translation[0] = x;
+	node->translation[1] = y;
+	node->translation[2] = z;
+	scene_graph_mark(graph, node);
+}
+
+/* Angles in degrees, applied like SetTransformMatrix */
+void scene_graph_set_rotation(scene_graph *graph, int handle, float anglex, float angley, float anglez)
+{
+	scene_node *node = &graph->nodes.items[graph->position_of.items[handle]];
+
+	if(node->rotation[0] == anglex && node->rotation[1] == angley && node->rotation[2] == anglez)
+		return;
+
+	node->rotation[0] = anglex;
+	node->rotation[1] = angley;
+	node->rotation[2] = anglez;
+	scene_graph_mark(graph, node);
+}
+
+void scene_graph_set_scale(scene_graph *graph, int handle, float x, float y, float z)
+{
+	scene_node *node = &graph->nodes.items[graph->position_of.items[handle]];
+
+	if(node->scale[0] == x && node->scale[1] == y && node->scale[2] == z)
+		return;
+
+	node->scale[0] = x;
+	node->scale[1] = y;
+	node->scale[2] = z;
+	scene_graph_mark(graph, node);
+}
+
+/* Recompute the world matrices of all marked subtrees; returns the
+ * number of nodes recomputed, -1 if out of memory */
+int scene_graph_update(scene_graph *graph)
+{
+	int *positions = graph->dirty.items;
+	int covered = 0, updated = 0, count;
+	int i;
+
+	//stamps of earlier updates stop counting as changed
+	graph->update_count++;
+	graph->changed.count = 0;
+
+	if(!graph->sorted)
+	{
+		if(!scene_graph_sort(graph))
+			return -1;
+		for(i=0; i<graph->nodes.count; i++)
+			graph->nodes.items[i].local_dirty = 1;
+		graph->dirty.count = 0;
+		graph->sorted = 1;
+		return scene_graph_update_range(graph, 0, graph->nodes.count) ? graph->nodes.count : -1;
+	}
+
+	//front to back, so parents of a range are always current; ranges
+	//inside a range already updated are skipped
+	for(i=0; i<graph->dirty.count; i++)
+		positions[i] = graph->position_of.items[positions[i]];
+	qsort(positions, graph->dirty.count, sizeof(int), scene_graph_compare_positions);
+
+	for(i=0; i<graph->dirty.count; i++)
+	{
+		if(positions[i] < covered)
+			continue;
+
+		covered = graph->nodes.items[positions[i]].end;
+		count = scene_graph_update_range(graph, positions[i], covered);
+		if(count == 0)
+		{
+			//the list now holds positions, not handles; the next
+			//update recomputes the whole hierarchy instead
+			graph->sorted = 0;
+			graph->dirty.count = 0;
+			return -1;
+		}
+		updated += count;
+	}
+
+	graph->dirty.count = 0;
+	return updated;
+}
+
+/* World matrix of a node as of the last update, 16 floats in the
+ * layout of Matrix.h; valid until nodes are added */
+const float* scene_graph_world(const scene_graph *graph, int handle)
+{
+	return graph->worlds.items + 16 * graph->position_of.items[handle];
+}
+
+/* Whether the last update rewrote the world matrix of a node */
+int scene_graph_changed(const scene_graph *graph, int handle)
+{
+	return graph->update_count > 0 &&
+	       graph->nodes.items[graph->position_of.items[handle]].updated == graph->update_count;
+}
+
+void scene_graph_free(scene_graph *graph)
+{
+	scene_nodes_free(&graph->nodes);
+	float_vector_free(&graph->locals);
+	float_vector_free(&graph->worlds);
+	int_vector_free(&graph->position_of);
+	int_vector_free(&graph->dirty);
+	int_vector_free(&graph->changed);
+	transform_batch_free(&graph->batch);
+	int_vector_free(&graph->batch_nodes);
+	float_vector_free(&graph->batch_matrices);
+}
@@ -0,0 +1,80 @@
+/******************************************************************
+*
+* SceneGraph.h
+*
+* Description: Hierarchy of transforms. Every node has a parent (or
+*              none), a local translation, rotation and scale, and a
+*              world matrix, the product of the world matrix of its
+*              parent and its local matrix.
+*
+*              Nodes are kept in one flat array in depth first order,
+*              so parents come before their children and every
+*              subtree is one contiguous range. Nodes are addressed
+*              by the handle returned when adding them, which stays
+*              valid when the array is reordered.
+*
+*              Changing a local transform only marks the node; an
+*              update recomputes the ranges of the marked subtrees in
+*              one pass from front to back, so its time grows with
+*              the parts that moved, not with the whole hierarchy.
+*              The local matrices marked in a range are evaluated
+*              together as one transform batch.
+*              Adding nodes reorders the array and recomputes all
+*              nodes on the next update.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __SCENE_GRAPH_H
+#define __SCENE_GRAPH_H
+
+#include "Vector.h"
+#include "Transform.h"
+
+#define SCENE_GRAPH_NONE -1
+
+typedef struct
+{
+	int parent;                 //position of the parent, SCENE_GRAPH_NONE for roots
+	int end;                    //position after the last node of the subtree
+	int handle;
+	float translation[3];
+	float rotation[3];          //degrees, composed like SetTransformMatrix
+	float scale[3];
+	char local_dirty;           //local matrix outdated, handle in the dirty list
+	unsigned int updated;       //update that last rewrote the world matrix
+} scene_node;
+
+VECTOR_DECLARE(scene_nodes, scene_node)
+
+typedef struct
+{
+	scene_nodes nodes;          //depth first order
+	float_vector locals;        //16 floats per node, in the order of nodes
+	float_vector worlds;
+	int_vector position_of;     //per handle
+	int_vector dirty;           //handles with changed local transforms
+	int_vector changed;         //handles whose world matrix the last update wrote
+	transform_batch batch;      //local transforms of the marked nodes of a range
+	int_vector batch_nodes;     //their positions
+	float_vector batch_matrices;
+	unsigned int update_count;
+	char sorted;                //nodes are in depth first order
+} scene_graph;
+
+void scene_graph_make(scene_graph *graph);
+int scene_graph_add(scene_graph *graph, int parent);
+void scene_graph_set_translation(scene_graph *graph, int handle, float x, float y, float z);
+void scene_graph_set_rotation(scene_graph *graph, int handle, float anglex, float angley, float anglez);
+void scene_graph_set_scale(scene_graph *graph, int handle, float x, float y, float z);
+int scene_graph_update(scene_graph *graph);
+const float* scene_graph_world(const scene_graph *graph, int handle);
+int scene_graph_changed(const scene_graph *graph, int handle);
+void scene_graph_free(scene_graph *graph);
+
+#endif
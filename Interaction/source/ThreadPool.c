@@ -0,0 +1,241 @@
+/******************************************************************
+*
+* ThreadPool.c
+*
+* Description: Fixed set of worker threads executing submitted
+*              jobs from a shared queue. Finished jobs can be
+*              collected one by one in completion order.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ThreadPool.h"
+
+#define THREAD_POOL_START_CAPACITY 16
+
+
+// internal helper functions
+/* Room in the finished ring for count jobs */
+int thread_pool_reserve_finished(thread_pool *pool, int count)
+{
+	int i;
+	int capacity = pool->finished_capacity;
+	void **finished;
+
+	if(count <= capacity)
+		return 1;
+
+	while(capacity < count)
+		capacity *= 2;
+	finished = (void**) malloc(sizeof(void*) * capacity);
+	if(finished == NULL)
+		return 0;
+
+	for(i=0; i<pool->finished_count; i++)
+		finished[i] = pool->finished[(pool->finished_first + i) % pool->finished_capacity];
+
+	free(pool->finished);
+	pool->finished = finished;
+	pool->finished_capacity = capacity;
+	pool->finished_first = 0;
+	return 1;
+}
+
+/* Never fails, the slot was reserved when the job was submitted */
+void thread_pool_add_finished(thread_pool *pool, void *argument)
+{
+	pool->finished[(pool->finished_first + pool->finished_count) % pool->finished_capacity] = argument;
+	pool->finished_count++;
+}
+
+void* thread_pool_worker(void *argument)
+{
+	thread_pool *pool = (thread_pool*) argument;
+	thread_pool_job job;
+
+	pthread_mutex_lock(&pool->lock);
+	for(;;)
+	{
+		while(pool->job_count == 0 && !pool->shutdown)
+			pthread_cond_wait(&pool->job_available, &pool->lock);
+
+		if(pool->job_count == 0 && pool->shutdown)
+			break;
+
+		job = pool->jobs[pool->job_first];
+		pool->job_first = (pool->job_first + 1) % pool->job_capacity;
+		pool->job_count--;
+		pool->jobs_running++;
+		pthread_mutex_unlock(&pool->lock);
+
+		job.function(job.argument);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->jobs_running--;
+		thread_pool_add_finished(pool, job.argument);
+		pthread_cond_broadcast(&pool->jobs_finished);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+int thread_pool_grow(thread_pool *pool)
+{
+	int i;
+	int capacity = pool->job_capacity*2;
+	thread_pool_job *jobs = (thread_pool_job*) malloc(sizeof(thread_pool_job) * capacity);
+
+	if(jobs == NULL)
+		return 0;
+
+	for(i=0; i<pool->job_count; i++)
+		jobs[i] = pool->jobs[(pool->job_first + i) % pool->job_capacity];
+
+	free(pool->jobs);
+	pool->jobs = jobs;
+	pool->job_capacity = capacity;
+	pool->job_first = 0;
+	return 1;
+}
+//end helpers
+
+int thread_pool_default_size()
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
+int thread_pool_make(thread_pool *pool, int thread_count)
+{
+	int i;
+
+	if(thread_count <= 0)
+		thread_count = thread_pool_default_size();
+
+	pool->threads = (pthread_t*) malloc(sizeof(pthread_t) * thread_count);
+	pool->jobs = (thread_pool_job*) malloc(sizeof(thread_pool_job) * THREAD_POOL_START_CAPACITY);
+	pool->job_capacity = THREAD_POOL_START_CAPACITY;
+	pool->finished = (void**) malloc(sizeof(void*) * THREAD_POOL_START_CAPACITY);
+	pool->finished_capacity = THREAD_POOL_START_CAPACITY;
+	pool->finished_first = 0;
+	pool->finished_count = 0;
+	pool->job_first = 0;
+	pool->job_count = 0;
+	pool->jobs_running = 0;
+	pool->shutdown = 0;
+	pool->thread_count = 0;
+
+	if(pool->threads == NULL || pool->jobs == NULL || pool->finished == NULL)
+	{
+		free(pool->threads);
+		free(pool->jobs);
+		free(pool->finished);
+		return 0;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->job_available, NULL);
+	pthread_cond_init(&pool->jobs_finished, NULL);
+
+	for(i=0; i<thread_count; i++)
+	{
+		if(pthread_create(&pool->threads[i], NULL, thread_pool_worker, pool) != 0)
+			break;
+		pool->thread_count++;
+	}
+
+	if(pool->thread_count == 0)
+	{
+		thread_pool_free(pool);
+		return 0;
+	}
+
+	return 1;
+}
+
+int thread_pool_submit(thread_pool *pool, thread_pool_function function, void *argument)
+{
+	pthread_mutex_lock(&pool->lock);
+
+	//every queued or running job has its place among the finished ones
+	if(!thread_pool_reserve_finished(pool, pool->finished_count + pool->job_count + pool->jobs_running + 1) ||
+	   (pool->job_count == pool->job_capacity && !thread_pool_grow(pool)))
+	{
+		pthread_mutex_unlock(&pool->lock);
+		return 0;
+	}
+
+	pool->jobs[(pool->job_first + pool->job_count) % pool->job_capacity].function = function;
+	pool->jobs[(pool->job_first + pool->job_count) % pool->job_capacity].argument = argument;
+	pool->job_count++;
+
+	pthread_cond_signal(&pool->job_available);
+	pthread_mutex_unlock(&pool->lock);
+	return 1;
+}
+
+void thread_pool_wait(thread_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	while(pool->job_count != 0 || pool->jobs_running != 0)
+		pthread_cond_wait(&pool->jobs_finished, &pool->lock);
+	pool->finished_first = 0;
+	pool->finished_count = 0;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+int thread_pool_wait_next(thread_pool *pool, void **argument)
+{
+	pthread_mutex_lock(&pool->lock);
+	while(pool->finished_count == 0 && (pool->job_count != 0 || pool->jobs_running != 0))
+		pthread_cond_wait(&pool->jobs_finished, &pool->lock);
+
+	//nothing finished and nothing left to run
+	if(pool->finished_count == 0)
+	{
+		pthread_mutex_unlock(&pool->lock);
+		return 0;
+	}
+
+	*argument = pool->finished[pool->finished_first];
+	pool->finished_first = (pool->finished_first + 1) % pool->finished_capacity;
+	pool->finished_count--;
+	pthread_mutex_unlock(&pool->lock);
+	return 1;
+}
+
+void thread_pool_free(thread_pool *pool)
+{
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->shutdown = 1;
+	pthread_cond_broadcast(&pool->job_available);
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i=0; i<pool->thread_count; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->job_available);
+	pthread_cond_destroy(&pool->jobs_finished);
+
+	free(pool->threads);
+	free(pool->jobs);
+	free(pool->finished);
+	pool->threads = NULL;
+	pool->jobs = NULL;
+	pool->finished = NULL;
+	pool->thread_count = 0;
+}
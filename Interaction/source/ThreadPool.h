@@ -0,0 +1,60 @@
+/******************************************************************
+*
+* ThreadPool.h
+*
+* Description: Fixed set of worker threads executing submitted
+*              jobs from a shared queue. Finished jobs can be
+*              collected one by one in completion order.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __THREAD_POOL_H
+#define __THREAD_POOL_H
+
+#include <pthread.h>
+
+typedef void (*thread_pool_function)(void *argument);
+
+typedef struct
+{
+	thread_pool_function function;
+	void *argument;
+} thread_pool_job;
+
+typedef struct
+{
+	pthread_t *threads;
+	int thread_count;
+
+	pthread_mutex_t lock;
+	pthread_cond_t job_available;
+	pthread_cond_t jobs_finished;
+
+	thread_pool_job *jobs;  //ring buffer of queued jobs
+	int job_capacity;
+	int job_first;
+	int job_count;
+
+	int jobs_running;
+	char shutdown;
+
+	void **finished;        //arguments of finished jobs in completion order
+	int finished_capacity;
+	int finished_first;
+	int finished_count;
+} thread_pool;
+
+int thread_pool_default_size();
+int thread_pool_make(thread_pool *pool, int thread_count);
+int thread_pool_submit(thread_pool *pool, thread_pool_function function, void *argument);
+void thread_pool_wait(thread_pool *pool);
+int thread_pool_wait_next(thread_pool *pool, void **argument);
+void thread_pool_free(thread_pool *pool);
+
+#endif
@@ -0,0 +1,325 @@
+/******************************************************************
+*
+* Transform.c
+*
+* Description: Batches of object transforms stored as one array per
+*              parameter, evaluated into model matrices in one pass.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Matrix.h"
+#include "Transform.h"
+
+#if defined(__SSE2__) && !defined(MATRIX_NO_SIMD)
+#define TRANSFORM_SSE
+#include <emmintrin.h>
+#endif
+
+#define TRANSFORM_PARAMETERS 9
+#define TRANSFORM_DEGREES ((float)(M_PI/180.0))
+
+/* Part of the batch evaluated by one thread */
+typedef struct
+{
+	const transform_batch *batch;
+	float *matrices;
+	int first;
+	int count;
+} transform_job;
+
+
+// internal helper functions
+int transform_batch_reserve(transform_batch *batch, int capacity)
+{
+	float *storage;
+	float **arrays[TRANSFORM_PARAMETERS];
+	int i;
+
+	if(capacity <= batch->capacity)
+		return 1;
+
+	//whole groups of four, so the vector loads never leave an array
+	capacity = (capacity + 3) & ~3;
+	storage = (float*) malloc(sizeof(float) * TRANSFORM_PARAMETERS * capacity);
+	if(storage == NULL)
+		return 0;
+
+	arrays[0] = &batch->translation_x;
+	arrays[1] = &batch->translation_y;
+	arrays[2] = &batch->translation_z;
+	arrays[3] = &batch->rotation_x;
+	arrays[4] = &batch->rotation_y;
+	arrays[5] = &batch->rotation_z;
+	arrays[6] = &batch->scale_x;
+	arrays[7] = &batch->scale_y;
+	arrays[8] = &batch->scale_z;
+
+	for(i=0; i<TRANSFORM_PARAMETERS; i++)
+	{
+		if(batch->count > 0)
+			memcpy(storage + i*capacity, *arrays[i], sizeof(float) * batch->count);
+		*arrays[i] = storage + i*capacity;
+	}
+
+	free(batch->storage);
+	batch->storage = storage;
+	batch->capacity = capacity;
+	return 1;
+}
+
+#ifdef TRANSFORM_SSE
+/* Sine and cosine of four angles in radians; polynomials and range
+ * reduction after Cephes, accurate to about 1e-7 for |x| < 8192 */
+void transform_sincos(__m128 x, __m128 *sine, __m128 *cosine)
+{
+	const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 sign_sin, y, z, poly_sin, poly_cos, select;
+	__m128i j, swap_sin, sign_cos;
+
+	sign_sin = _mm_and_ps(x, sign_mask);
+	x = _mm_andnot_ps(sign_mask, x);
+
+	//octant, rounded up to an even one
+	j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+	j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+	y = _mm_cvtepi32_ps(j);
+
+	swap_sin = _mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29);
+	sign_cos = _mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29);
+	select = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+	//x - y*pi/4 in three parts to keep the precision
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+	z = _mm_mul_ps(x, x);
+
+	poly_cos = _mm_set1_ps(2.443315711809948e-5f);
+	poly_cos = _mm_add_ps(_mm_mul_ps(poly_cos, z), _mm_set1_ps(-1.388731625493765e-3f));
+	poly_cos = _mm_add_ps(_mm_mul_ps(poly_cos, z), _mm_set1_ps(4.166664568298827e-2f));
+	poly_cos = _mm_mul_ps(_mm_mul_ps(poly_cos, z), z);
+	poly_cos = _mm_sub_ps(poly_cos, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	poly_cos = _mm_add_ps(poly_cos, _mm_set1_ps(1.0f));
+
+	poly_sin = _mm_set1_ps(-1.9515295891e-4f);
+	poly_sin = _mm_add_ps(_mm_mul_ps(poly_sin, z), _mm_set1_ps(8.3321608736e-3f));
+	poly_sin = _mm_add_ps(_mm_mul_ps(poly_sin, z), _mm_set1_ps(-1.6666654611e-1f));
+	poly_sin = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(poly_sin, z), x), x);
+
+	sign_sin = _mm_xor_ps(sign_sin, _mm_castsi128_ps(swap_sin));
+	*sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(select, poly_sin), _mm_andnot_ps(select, poly_cos)), sign_sin);
+	*cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(select, poly_cos), _mm_andnot_ps(select, poly_sin)),
+	                     _mm_castsi128_ps(sign_cos));
+}
+
+/* Four matrices from the parameters starting at p[0] .. p[8] */
+void transform_evaluate_four(const float **p, float *matrices)
+{
+	__m128 sin_x, cos_x, sin_y, cos_y, sin_z, cos_z;
+	__m128 scale_x, scale_y, scale_z, cy_cz, sy_sz, cy_sz, sy_cz;
+	__m128 r0, r1, r2, r3, one;
+	__m128 m[12];
+
+	transform_sincos(_mm_mul_ps(_mm_loadu_ps(p[3]), _mm_set1_ps(TRANSFORM_DEGREES)), &sin_x, &cos_x);
+	transform_sincos(_mm_mul_ps(_mm_loadu_ps(p[4]), _mm_set1_ps(TRANSFORM_DEGREES)), &sin_y, &cos_y);
+	transform_sincos(_mm_mul_ps(_mm_loadu_ps(p[5]), _mm_set1_ps(TRANSFORM_DEGREES)), &sin_z, &cos_z);
+	scale_x = _mm_loadu_ps(p[6]);
+	scale_y = _mm_loadu_ps(p[7]);
+	scale_z = _mm_loadu_ps(p[8]);
+
+	cy_cz = _mm_mul_ps(cos_y, cos_z);
+	sy_sz = _mm_mul_ps(sin_y, sin_z);
+	cy_sz = _mm_mul_ps(cos_y, sin_z);
+	sy_cz = _mm_mul_ps(sin_y, cos_z);
+
+	//element i of the four matrices
+	m[0] = _mm_mul_ps(_mm_add_ps(cy_cz, _mm_mul_ps(sy_sz, sin_x)), scale_x);
+	m[1] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sy_cz, sin_x), cy_sz), scale_y);
+	m[2] = _mm_mul_ps(_mm_mul_ps(sin_y, cos_x), scale_z);
+	m[3] = _mm_loadu_ps(p[0]);
+	m[4] = _mm_mul_ps(_mm_mul_ps(cos_x, sin_z), scale_x);
+	m[5] = _mm_mul_ps(_mm_mul_ps(cos_x, cos_z), scale_y);
+	m[6] = _mm_mul_ps(_mm_xor_ps(sin_x, _mm_set1_ps(-0.0f)), scale_z);
+	m[7] = _mm_loadu_ps(p[1]);
+	m[8] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cy_sz, sin_x), sy_cz), scale_x);
+	m[9] = _mm_mul_ps(_mm_add_ps(sy_sz, _mm_mul_ps(cy_cz, sin_x)), scale_y);
+	m[10] = _mm_mul_ps(_mm_mul_ps(cos_y, cos_x), scale_z);
+	m[11] = _mm_loadu_ps(p[2]);
+
+	//rows of four elements back to one matrix after another
+	one = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+	r0 = m[0]; r1 = m[1]; r2 = m[2]; r3 = m[3];
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(&matrices[0], r0);
+	_mm_storeu_ps(&matrices[16], r1);
+	_mm_storeu_ps(&matrices[32], r2);
+	_mm_storeu_ps(&matrices[48], r3);
+
+	r0 = m[4]; r1 = m[5]; r2 = m[6]; r3 = m[7];
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(&matrices[4], r0);
+	_mm_storeu_ps(&matrices[20], r1);
+	_mm_storeu_ps(&matrices[36], r2);
+	_mm_storeu_ps(&matrices[52], r3);
+
+	r0 = m[8]; r1 = m[9]; r2 = m[10]; r3 = m[11];
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(&matrices[8], r0);
+	_mm_storeu_ps(&matrices[24], r1);
+	_mm_storeu_ps(&matrices[40], r2);
+	_mm_storeu_ps(&matrices[56], r3);
+
+	_mm_storeu_ps(&matrices[12], one);
+	_mm_storeu_ps(&matrices[28], one);
+	_mm_storeu_ps(&matrices[44], one);
+	_mm_storeu_ps(&matrices[60], one);
+}
+#else
+void transform_evaluate_one(const float **p, int i, float *matrix)
+{
+	SetTransformMatrix(p[0][i], p[1][i], p[2][i], p[3][i], p[4][i], p[5][i],
+	                   p[6][i], p[7][i], p[8][i], matrix);
+}
+#endif
+
+void transform_evaluate_range(const transform_batch *batch, float *matrices, int first, int count)
+{
+	const float *p[TRANSFORM_PARAMETERS];
+	int i;
+#ifdef TRANSFORM_SSE
+	int k;
+	const float *tail[TRANSFORM_PARAMETERS];
+	float tail_parameters[TRANSFORM_PARAMETERS][4];
+	float tail_matrices[4*16];
+#endif
+
+	p[0] = batch->translation_x + first;
+	p[1] = batch->translation_y + first;
+	p[2] = batch->translation_z + first;
+	p[3] = batch->rotation_x + first;
+	p[4] = batch->rotation_y + first;
+	p[5] = batch->rotation_z + first;
+	p[6] = batch->scale_x + first;
+	p[7] = batch->scale_y + first;
+	p[8] = batch->scale_z + first;
+	matrices += first*16;
+
+#ifdef TRANSFORM_SSE
+	for(i=0; i+4<=count; i+=4)
+	{
+		transform_evaluate_four(p, matrices + i*16);
+		for(k=0; k<TRANSFORM_PARAMETERS; k++)
+			p[k] += 4;
+	}
+
+	//last incomplete group through a padded copy
+	if(i < count)
+	{
+		for(k=0; k<TRANSFORM_PARAMETERS; k++)
+		{
+			memset(tail_parameters[k], 0, sizeof(tail_parameters[k]));
+			memcpy(tail_parameters[k], p[k], sizeof(float) * (count - i));
+			tail[k] = tail_parameters[k];
+		}
+		transform_evaluate_four(tail, tail_matrices);
+		memcpy(matrices + i*16, tail_matrices, sizeof(float) * 16 * (count - i));
+	}
+#else
+	for(i=0; i<count; i++)
+		transform_evaluate_one(p, i, matrices + i*16);
+#endif
+}
+
+void transform_job_run(void *argument)
+{
+	transform_job *job = (transform_job*) argument;
+	transform_evaluate_range(job->batch, job->matrices, job->first, job->count);
+}
+//end helpers
+
+int transform_batch_make(transform_batch *batch, int capacity)
+{
+	memset(batch, 0, sizeof(transform_batch));
+	if(capacity < 4)
+		capacity = 4;
+	return transform_batch_reserve(batch, capacity);
+}
+
+/* Append an identity transform; returns its index or -1 */
+int transform_batch_add(transform_batch *batch)
+{
+	int i = batch->count;
+
+	if(i == batch->capacity && !transform_batch_reserve(batch, batch->capacity > 0 ? batch->capacity*2 : 4))
+		return -1;
+
+	batch->translation_x[i] = 0.0f;
+	batch->translation_y[i] = 0.0f;
+	batch->translation_z[i] = 0.0f;
+	batch->rotation_x[i] = 0.0f;
+	batch->rotation_y[i] = 0.0f;
+	batch->rotation_z[i] = 0.0f;
+	batch->scale_x[i] = 1.0f;
+	batch->scale_y[i] = 1.0f;
+	batch->scale_z[i] = 1.0f;
+
+	batch->count++;
+	return i;
+}
+
+/* Write count matrices of 16 floats; pool may be NULL */
+void transform_batch_evaluate(const transform_batch *batch, float *matrices, thread_pool *pool)
+{
+	transform_job *jobs;
+	int job_count, per_job, first, i;
+
+	if(pool == NULL || pool->thread_count < 2 || batch->count < TRANSFORM_PARALLEL_THRESHOLD)
+	{
+		transform_evaluate_range(batch, matrices, 0, batch->count);
+		return;
+	}
+
+	job_count = pool->thread_count;
+	jobs = (transform_job*) malloc(sizeof(transform_job) * job_count);
+	if(jobs == NULL)
+	{
+		transform_evaluate_range(batch, matrices, 0, batch->count);
+		return;
+	}
+
+	//whole groups of four per job, the last one takes the rest
+	per_job = ((batch->count + job_count - 1)/job_count + 3) & ~3;
+	first = 0;
+	for(i=0; i<job_count && first<batch->count; i++)
+	{
+		jobs[i].batch = batch;
+		jobs[i].matrices = matrices;
+		jobs[i].first = first;
+		jobs[i].count = batch->count - first < per_job ? batch->count - first : per_job;
+		first += jobs[i].count;
+
+		if(!thread_pool_submit(pool, transform_job_run, &jobs[i]))
+			transform_job_run(&jobs[i]);
+	}
+	thread_pool_wait(pool);
+
+	free(jobs);
+}
+
+void transform_batch_free(transform_batch *batch)
+{
+	free(batch->storage);
+	memset(batch, 0, sizeof(transform_batch));
+}
@@ -0,0 +1,54 @@
+/******************************************************************
+*
+* Transform.h
+*
+* Description: Batches of object transforms stored as one array per
+*              parameter, evaluated into model matrices in one pass.
+*
+*              Every transform is translation * Y * X * Z rotation *
+*              scale, with angles in degrees like SetRotationX/Y/Z.
+*              The matrices are written in the layout of Matrix.h,
+*              16 floats each; four transforms are evaluated at a
+*              time with SSE, and large batches are split across the
+*              threads of a pool.
+*
+* Computer Graphics Proseminar SS 2015
+*
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __TRANSFORM_H
+#define __TRANSFORM_H
+
+#include "ThreadPool.h"
+
+/* Batches smaller than this are evaluated on the calling thread */
+#define TRANSFORM_PARALLEL_THRESHOLD 4096
+
+typedef struct
+{
+	float *translation_x;
+	float *translation_y;
+	float *translation_z;
+	float *rotation_x;          //degrees
+	float *rotation_y;
+	float *rotation_z;
+	float *scale_x;
+	float *scale_y;
+	float *scale_z;
+
+	int count;
+	int capacity;
+
+	float *storage;             //single block the arrays point into
+} transform_batch;
+
+int transform_batch_make(transform_batch *batch, int capacity);
+int transform_batch_add(transform_batch *batch);
+void transform_batch_evaluate(const transform_batch *batch, float *matrices, thread_pool *pool);
+void transform_batch_free(transform_batch *batch);
+
+#endif
@@ -0,0 +1,75 @@
+/******************************************************************
+*
+* Vector.c
+*
+* Description: String pool used for the names of vector elements.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+/* Standard includes */
+#include <string.h>
+
+#include "Vector.h"
+
+
+void name_pool_make(name_pool *pool)
+{
+	char_vector_make(&pool->chars, 0);
+	int_vector_make(&pool->offsets, 0);
+}
+
+int name_pool_add(name_pool *pool, const char *name)
+{
+	int length;
+	int *offset = int_vector_push(&pool->offsets);
+
+	if(offset == NULL)
+		return -1;
+
+	*offset = -1;
+	if(name != NULL)
+	{
+		length = strlen(name) + 1;
+		if(!char_vector_append(&pool->chars, name, length))
+		{
+			pool->offsets.count--;
+			return -1;
+		}
+		*offset = pool->chars.count - length;
+	}
+
+	return pool->offsets.count - 1;
+}
+
+const char* name_pool_get(const name_pool *pool, int index)
+{
+	if(index < 0 || index >= pool->offsets.count || pool->offsets.items[index] < 0)
+		return NULL;
+
+	return pool->chars.items + pool->offsets.items[index];
+}
+
+int name_pool_find(const name_pool *pool, const char *name)
+{
+	int i;
+
+	for(i=0; i < pool->offsets.count; i++)
+	{
+		if(pool->offsets.items[i] >= 0 && strcmp(pool->chars.items + pool->offsets.items[i], name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+void name_pool_free(name_pool *pool)
+{
+	char_vector_free(&pool->chars);
+	int_vector_free(&pool->offsets);
+}
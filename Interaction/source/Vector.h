@@ -0,0 +1,112 @@
+/******************************************************************
+*
+* Vector.h
+*
+* Description: Growable arrays storing their elements inline. 
+*              VECTOR_DECLARE(name, type) generates the struct
+*              'name' and the functions name_make, name_reserve,
+*              name_push, name_append and name_free; the array grows
+*              by doubling its capacity with realloc.
+*
+*              Names of elements may be kept in a name_pool next to
+*              a vector; all strings of a pool share one buffer.
+*
+* Computer Graphics Proseminar SS 2015
+* 
+* Interactive Graphics and Simulation Group
+* Institute of Computer Science
+* University of Innsbruck
+*
+*******************************************************************/
+
+#ifndef __VECTOR_H
+#define __VECTOR_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#define VECTOR_MIN_CAPACITY 16
+
+#define VECTOR_DECLARE(name, type)                                              \
+typedef struct                                                                  \
+{                                                                               \
+	type *items;                                                                \
+	int count;                                                                  \
+	int capacity;                                                               \
+} name;                                                                         \
+                                                                                \
+static inline int name##_reserve(name *vector, int capacity)                    \
+{                                                                               \
+	type *grown;                                                                \
+	int new_capacity = vector->capacity > 0 ? vector->capacity : VECTOR_MIN_CAPACITY; \
+                                                                                \
+	if(capacity <= vector->capacity)                                            \
+		return 1;                                                               \
+                                                                                \
+	while(new_capacity < capacity)                                              \
+		new_capacity *= 2;                                                      \
+                                                                                \
+	grown = (type*) realloc(vector->items, sizeof(type) * new_capacity);        \
+	if(grown == NULL)                                                           \
+		return 0;                                                               \
+                                                                                \
+	vector->items = grown;                                                      \
+	vector->capacity = new_capacity;                                            \
+	return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline void name##_make(name *vector, int capacity)                      \
+{                                                                               \
+	vector->items = NULL;                                                       \
+	vector->count = 0;                                                          \
+	vector->capacity = 0;                                                       \
+	if(capacity > 0)                                                            \
+		name##_reserve(vector, capacity);                                       \
+}                                                                               \
+                                                                                \
+/* Appends one uninitialized element; NULL if out of memory */                  \
+static inline type* name##_push(name *vector)                                   \
+{                                                                               \
+	if(vector->count == vector->capacity && !name##_reserve(vector, vector->count + 1)) \
+		return NULL;                                                            \
+	return &vector->items[vector->count++];                                     \
+}                                                                               \
+                                                                                \
+static inline int name##_append(name *vector, const type *values, int count)    \
+{                                                                               \
+	if(count <= 0)                                                              \
+		return 1;                                                               \
+	if(!name##_reserve(vector, vector->count + count))                          \
+		return 0;                                                               \
+	memcpy(vector->items + vector->count, values, sizeof(type) * count);        \
+	vector->count += count;                                                     \
+	return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline void name##_free(name *vector)                                    \
+{                                                                               \
+	free(vector->items);                                                        \
+	vector->items = NULL;                                                       \
+	vector->count = 0;                                                          \
+	vector->capacity = 0;                                                       \
+}
+
+VECTOR_DECLARE(int_vector, int)
+VECTOR_DECLARE(char_vector, char)
+VECTOR_DECLARE(float_vector, float)
+
+/* Strings stored back to back in one buffer, addressed by index; 
+ * pointers returned by name_pool_get are valid until the next add */
+typedef struct
+{
+	char_vector chars;
+	int_vector offsets;         //-1 for elements without a name
+} name_pool;
+
+void name_pool_make(name_pool *pool);
+int name_pool_add(name_pool *pool, const char *name);
+const char* name_pool_get(const name_pool *pool, int index);
+int name_pool_find(const name_pool *pool, const char *name);
+void name_pool_free(name_pool *pool);
+
+#endif